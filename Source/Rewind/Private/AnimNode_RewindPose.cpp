@@ -0,0 +1,77 @@
+﻿#include "AnimNode_RewindPose.h"
+
+#include "RewindComponent.h"
+#include "Animation/AnimInstance.h"
+#include "Animation/AnimInstanceProxy.h"
+#include "Engine/SkeletalMesh.h"
+
+void FAnimNode_RewindPose::Initialize_AnyThread(const FAnimationInitializeContext& Context)
+{
+	DECLARE_SCOPE_HIERARCHICAL_COUNTER_ANIMNODE(Initialize_AnyThread)
+	FAnimNode_Base::Initialize_AnyThread(Context);
+
+	Source.Initialize(Context);
+}
+
+void FAnimNode_RewindPose::CacheBones_AnyThread(const FAnimationCacheBonesContext& Context)
+{
+	DECLARE_SCOPE_HIERARCHICAL_COUNTER_ANIMNODE(CacheBones_AnyThread)
+
+	Source.CacheBones(Context);
+}
+
+void FAnimNode_RewindPose::PreUpdate(const UAnimInstance* InAnimInstance)
+{
+	if (!RewindComponent.IsValid())
+	{
+		const AActor* Owner{InAnimInstance->GetOwningActor()};
+		RewindComponent = Owner ? Owner->FindComponentByClass<URewindComponent>() : nullptr;
+	}
+
+	const URewindComponent* Component{RewindComponent.Get()};
+	RewindPose = Component && Component->IsReversingTime() ? &Component->GetPose_AnyThread() : nullptr;
+}
+
+void FAnimNode_RewindPose::Update_AnyThread(const FAnimationUpdateContext& Context)
+{
+	DECLARE_SCOPE_HIERARCHICAL_COUNTER_ANIMNODE(Update_AnyThread)
+
+	// The source graph holds still while the rewound pose is shown.
+	if (!RewindPose)
+	{
+		Source.Update(Context);
+	}
+}
+
+void FAnimNode_RewindPose::Evaluate_AnyThread(FPoseContext& Output)
+{
+	DECLARE_SCOPE_HIERARCHICAL_COUNTER_ANIMNODE(Evaluate_AnyThread)
+
+	const FBoneContainer& RequiredBones{Output.Pose.GetBoneContainer()};
+	const USkeletalMesh* SkeletalMesh{RequiredBones.GetSkeletalMeshAsset()};
+
+	// The pose is in the mesh's bone order, so it only applies to the mesh it was recorded from.
+	if (!RewindPose || !RewindPose->bIsValid || !SkeletalMesh || RewindPose->SkeletalMeshName != SkeletalMesh->GetFName()
+		|| RewindPose->LocalTransforms.Num() != RequiredBones.GetNumBones())
+	{
+		Source.Evaluate(Output);
+		return;
+	}
+
+	const TArray<FTransform>& LocalTransforms{RewindPose->LocalTransforms};
+	for (const FCompactPoseBoneIndex BoneIndex : Output.Pose.ForEachBoneIndex())
+	{
+		Output.Pose[BoneIndex] = LocalTransforms[RequiredBones.MakeMeshPoseIndex(BoneIndex).GetInt()];
+	}
+}
+
+void FAnimNode_RewindPose::GatherDebugData(FNodeDebugData& DebugData)
+{
+	DECLARE_SCOPE_HIERARCHICAL_COUNTER_ANIMNODE(GatherDebugData)
+
+	FString DebugLine{DebugData.GetNodeName(this)};
+	DebugLine += FString::Printf(TEXT("(Rewinding: %s)"), RewindPose ? TEXT("true") : TEXT("false"));
+	DebugData.AddDebugItem(DebugLine);
+
+	Source.GatherDebugData(DebugData);
+}
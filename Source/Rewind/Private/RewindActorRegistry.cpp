@@ -0,0 +1,207 @@
+﻿#include "RewindActorRegistry.h"
+
+#include "RewindComponent.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "GameFramework/Character.h"
+
+int32 FRewindActorRegistry::Add(AActor* InActor, URewindComponent* InComponent)
+{
+	check(InActor && InComponent && InComponent->GetOwner() == InActor);
+
+	if (const int32* ExistingSlot = SlotByActor.Find(InActor))
+	{
+		return *ExistingSlot;
+	}
+
+	const int32 Slot{Actors.Add(InActor)};
+	SlotByActor.Add(InActor, Slot);
+	ActorKeys.Add(InActor);
+	Components.Add(InComponent);
+
+	Characters.Add(Cast<ACharacter>(InActor));
+	Kinds.Add(ERewindActorKind::Other);
+	RootPrimitives.Add(nullptr);
+	Meshes.Add(nullptr);
+	BodyMeshes.Add(nullptr);
+	RefreshComponents(Slot);
+	Shapes.Add(RewindHistoryQuery::MakeShape(InActor));
+
+	PlaybackCursors.AddDefaulted();
+	OutOfData.Add(false);
+	RecordingLODs.Add(ERewindRecordingLOD::Full);
+	GroupRewinding.Add(false);
+	SampleAccumulators.Add(0.f);
+	RecordedTimeLimits.Add(MAX_flt);
+	Histories.AddDefaulted();
+	Futures.AddDefaulted();
+	Spills.AddDefaulted();
+	BodyHistories.AddDefaulted();
+	BodyStates.AddDefaulted();
+	IndexCursors.AddDefaulted();
+
+	const FIntVector Cell{GetGridCell(InActor->GetActorLocation())};
+	GridCells.Add(Cell);
+	AddToGrid(Slot, Cell);
+
+	return Slot;
+}
+
+int32 FRewindActorRegistry::Find(TObjectKey<AActor> InActor) const
+{
+	const int32* Slot = SlotByActor.Find(InActor);
+	return Slot ? *Slot : INDEX_NONE;
+}
+
+void FRewindActorRegistry::RemoveAtSwap(int32 Slot)
+{
+	check(Actors.IsValidIndex(Slot));
+
+	SlotByActor.Remove(ActorKeys[Slot]);
+	RemoveFromGrid(Slot);
+
+	const int32 LastSlot{Actors.Num() - 1};
+	if (Slot != LastSlot)
+	{
+		SlotByActor.FindChecked(ActorKeys[LastSlot]) = Slot;
+
+		auto& LastCell = Grid.FindChecked(GridCells[LastSlot]);
+		LastCell[LastCell.IndexOfByKey(LastSlot)] = Slot;
+	}
+
+	Actors.RemoveAtSwap(Slot, EAllowShrinking::No);
+	ActorKeys.RemoveAtSwap(Slot, EAllowShrinking::No);
+	Components.RemoveAtSwap(Slot, EAllowShrinking::No);
+	Kinds.RemoveAtSwap(Slot, EAllowShrinking::No);
+	RootPrimitives.RemoveAtSwap(Slot, EAllowShrinking::No);
+	Characters.RemoveAtSwap(Slot, EAllowShrinking::No);
+	Meshes.RemoveAtSwap(Slot, EAllowShrinking::No);
+	BodyMeshes.RemoveAtSwap(Slot, EAllowShrinking::No);
+	Shapes.RemoveAtSwap(Slot, EAllowShrinking::No);
+	PlaybackCursors.RemoveAtSwap(Slot, EAllowShrinking::No);
+	OutOfData.RemoveAtSwap(Slot, EAllowShrinking::No);
+	RecordingLODs.RemoveAtSwap(Slot, EAllowShrinking::No);
+	GroupRewinding.RemoveAtSwap(Slot, EAllowShrinking::No);
+	SampleAccumulators.RemoveAtSwap(Slot, EAllowShrinking::No);
+	RecordedTimeLimits.RemoveAtSwap(Slot, EAllowShrinking::No);
+	Histories.RemoveAtSwap(Slot, EAllowShrinking::No);
+	Futures.RemoveAtSwap(Slot, EAllowShrinking::No);
+	Spills.RemoveAtSwap(Slot, EAllowShrinking::No);
+	BodyHistories.RemoveAtSwap(Slot, EAllowShrinking::No);
+	BodyStates.RemoveAtSwap(Slot, EAllowShrinking::No);
+	IndexCursors.RemoveAtSwap(Slot, EAllowShrinking::No);
+	GridCells.RemoveAtSwap(Slot, EAllowShrinking::No);
+}
+
+void FRewindActorRegistry::RefreshComponents(int32 Slot)
+{
+	const AActor* Actor = Actors[Slot];
+	const ACharacter* Character = Characters[Slot];
+
+	// Root and character mesh are member reads, so they are simply taken again.
+	UPrimitiveComponent* RootPrimitive = Cast<UPrimitiveComponent>(Actor->GetRootComponent());
+	RootPrimitives[Slot] = IsValid(RootPrimitive) ? RootPrimitive : nullptr;
+	USkeletalMeshComponent* Mesh = Character ? Character->GetMesh() : nullptr;
+	Meshes[Slot] = IsValid(Mesh) ? Mesh : nullptr;
+	Kinds[Slot] = Character ? ERewindActorKind::Character : RootPrimitives[Slot] ? ERewindActorKind::Primitive : ERewindActorKind::Other;
+
+	// Any other mesh has to be searched for, which only happens once the cached one is gone.
+	if (!Components[Slot]->bRecordPhysicsBodies)
+	{
+		BodyMeshes[Slot] = nullptr;
+	}
+	else if (Character)
+	{
+		BodyMeshes[Slot] = Meshes[Slot];
+	}
+	else if (!IsValid(BodyMeshes[Slot]))
+	{
+		USkeletalMeshComponent* BodyMesh = Actor->FindComponentByClass<USkeletalMeshComponent>();
+		BodyMeshes[Slot] = IsValid(BodyMesh) ? BodyMesh : nullptr;
+	}
+}
+
+void FRewindActorRegistry::AddReferencedObjects(FReferenceCollector& Collector)
+{
+	Collector.AddReferencedObjects(RootPrimitives);
+	Collector.AddReferencedObjects(Meshes);
+	Collector.AddReferencedObjects(BodyMeshes);
+}
+
+void FRewindActorRegistry::SetGridCellSize(float InCellSize)
+{
+	const float NewCellSize{FMath::Max(InCellSize, 1.f)};
+	if (NewCellSize == GridCellSize) return;
+
+	GridCellSize = NewCellSize;
+	Grid.Reset();
+	for (int32 Slot = 0; Slot < Num(); ++Slot)
+	{
+		GridCells[Slot] = GetGridCell(Actors[Slot]->GetActorLocation());
+		AddToGrid(Slot, GridCells[Slot]);
+	}
+}
+
+void FRewindActorRegistry::UpdateGridLocation(int32 Slot, const FVector& Location)
+{
+	const FIntVector Cell{GetGridCell(Location)};
+	if (Cell == GridCells[Slot]) return;
+
+	RemoveFromGrid(Slot);
+	GridCells[Slot] = Cell;
+	AddToGrid(Slot, Cell);
+}
+
+void FRewindActorRegistry::GatherGridSlots(const FBox& Box, TArray<int32>& OutSlots) const
+{
+	const FIntVector MinCell{GetGridCell(Box.Min)};
+	const FIntVector MaxCell{GetGridCell(Box.Max)};
+	const FIntVector Extent{MaxCell - MinCell + FIntVector(1)};
+
+	// A box spanning more cells than are occupied is cheaper to test against the occupied ones.
+	if (static_cast<int64>(Extent.X) * Extent.Y * Extent.Z > Grid.Num())
+	{
+		for (const auto& Cell : Grid)
+		{
+			if (Cell.Key.X >= MinCell.X && Cell.Key.Y >= MinCell.Y && Cell.Key.Z >= MinCell.Z
+				&& Cell.Key.X <= MaxCell.X && Cell.Key.Y <= MaxCell.Y && Cell.Key.Z <= MaxCell.Z)
+			{
+				OutSlots.Append(Cell.Value);
+			}
+		}
+		return;
+	}
+
+	for (int32 Z = MinCell.Z; Z <= MaxCell.Z; ++Z)
+	{
+		for (int32 Y = MinCell.Y; Y <= MaxCell.Y; ++Y)
+		{
+			for (int32 X = MinCell.X; X <= MaxCell.X; ++X)
+			{
+				if (const auto* Cell = Grid.Find(FIntVector{X, Y, Z}))
+				{
+					OutSlots.Append(*Cell);
+				}
+			}
+		}
+	}
+}
+
+FIntVector FRewindActorRegistry::GetGridCell(const FVector& Location) const
+{
+	return FIntVector{FMath::FloorToInt32(Location.X / GridCellSize), FMath::FloorToInt32(Location.Y / GridCellSize), FMath::FloorToInt32(Location.Z / GridCellSize)};
+}
+
+void FRewindActorRegistry::AddToGrid(int32 Slot, const FIntVector& Cell)
+{
+	Grid.FindOrAdd(Cell).Add(Slot);
+}
+
+void FRewindActorRegistry::RemoveFromGrid(int32 Slot)
+{
+	auto& Cell = Grid.FindChecked(GridCells[Slot]);
+	Cell.RemoveSingleSwap(Slot, EAllowShrinking::No);
+	if (Cell.IsEmpty())
+	{
+		Grid.Remove(GridCells[Slot]);
+	}
+}
@@ -0,0 +1,71 @@
+﻿#include "RewindBodyHistory.h"
+
+TArrayView<FRewindBodyState> FRewindBodyHistory::AddFrame(double Timestamp, float MaxRecordedTime)
+{
+	while (!Frames.IsEmpty() && Timestamp - Frames.Head().Timestamp >= MaxRecordedTime)
+	{
+		Frames.PopHead();
+	}
+
+	Frames.AddTail_GetRef().Timestamp = Timestamp;
+	return Frames.GetPose(Frames.Num() - 1);
+}
+
+void FRewindBodyHistory::TrimTail(double Timestamp)
+{
+	while (!Frames.IsEmpty() && Frames.Tail().Timestamp > Timestamp)
+	{
+		Frames.PopTail();
+	}
+}
+
+void FRewindBodyHistory::TrimHead(double Timestamp)
+{
+	while (!Frames.IsEmpty() && Frames.Head().Timestamp < Timestamp)
+	{
+		Frames.PopHead();
+	}
+}
+
+bool FRewindBodyHistory::Sample(double Time, TArrayView<FRewindBodyState> Out) const
+{
+	check(Out.Num() == GetNumBodies());
+
+	// The tolerance covers the float running times playback steps the main history with.
+	if (Frames.IsEmpty() || Time < Frames.Head().Timestamp - UE_KINDA_SMALL_NUMBER) return false;
+
+	// First frame at or after Time, or the newest one
+	int32 Low{0};
+	int32 High{Frames.Num() - 1};
+	while (Low < High)
+	{
+		const int32 Middle{(Low + High) / 2};
+		if (Frames[Middle].Timestamp < Time)
+		{
+			Low = Middle + 1;
+		}
+		else
+		{
+			High = Middle;
+		}
+	}
+	const int32 Right{Low};
+	const int32 Left{FMath::Max(Right - 1, 0)};
+
+	const double Span{Frames[Right].Timestamp - Frames[Left].Timestamp};
+	const float Alpha{Span > UE_DOUBLE_SMALL_NUMBER ? static_cast<float>(FMath::Clamp((Time - Frames[Left].Timestamp) / Span, 0.0, 1.0)) : 1.f};
+
+	const auto LeftStates{Frames.GetPose(Left)};
+	const auto RightStates{Frames.GetPose(Right)};
+	for (int32 Index = 0; Index < Out.Num(); ++Index)
+	{
+		const auto& From = LeftStates[Index];
+		const auto& To = RightStates[Index];
+		auto& State = Out[Index];
+		State.Location = FMath::Lerp(From.Location, To.Location, Alpha);
+		State.Rotation = FQuat::Slerp(From.Rotation, To.Rotation, Alpha);
+		State.LinearVelocity = FMath::Lerp(From.LinearVelocity, To.LinearVelocity, Alpha);
+		State.AngularVelocity = FMath::Lerp(From.AngularVelocity, To.AngularVelocity, Alpha);
+	}
+	return true;
+}
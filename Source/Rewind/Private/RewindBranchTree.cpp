@@ -0,0 +1,173 @@
+﻿#include "RewindBranchTree.h"
+
+int64 FRewindBranchTree::GetMemoryBytes() const
+{
+	int64 Bytes{0};
+	for (const auto& Branch : Branches)
+	{
+		Bytes += Branch.GetMemoryBytes();
+	}
+	return Bytes;
+}
+
+void FRewindBranchTree::Reset()
+{
+	Branches.Reset();
+}
+
+void FRewindBranchTree::Fork(double ForkTimestamp, TConstArrayView<TObjectKey<AActor>> Actors, TArrayView<FActorData> Futures, int32 MaxBranches)
+{
+	check(Actors.Num() == Futures.Num());
+
+	FRewindBranch Branch;
+	Branch.Id = CurrentId;
+	Branch.ParentId = NextId;
+	Branch.ForkTimestamp = ForkTimestamp;
+	for (int32 Slot = 0; Slot < Futures.Num(); ++Slot)
+	{
+		auto& Future = Futures[Slot];
+		if (!Future.HasFrames()) continue;
+
+		if (MaxBranches > 0)
+		{
+			Branch.Suffixes.Add(Actors[Slot], MoveTemp(Future));
+			Future = FActorData();
+		}
+		else
+		{
+			Future.ResetFrames();
+		}
+	}
+	if (Branch.Suffixes.IsEmpty()) return;
+
+	// The live timeline goes on as a new branch, the frames it went back past keep the id they were recorded under.
+	// Branches forked off it up to this point only need frames that stay live, the later ones need the new branch's.
+	const int32 LiveId{NextId++};
+	for (auto& Other : Branches)
+	{
+		if (Other.ParentId == CurrentId && Other.ForkTimestamp <= ForkTimestamp)
+		{
+			Other.ParentId = LiveId;
+		}
+	}
+	Branches.Add(MoveTemp(Branch));
+	CurrentId = LiveId;
+
+	while (Branches.Num() > MaxBranches && RemoveOldest())
+	{
+	}
+}
+
+bool FRewindBranchTree::SwitchTo(int32 BranchId, TConstArrayView<TObjectKey<AActor>> Actors, TArrayView<FActorData> Histories, double& OutForkTimestamp)
+{
+	check(Actors.Num() == Histories.Num());
+
+	if (FindIndex(BranchId) == INDEX_NONE) return false;
+
+	// Path from the branch up to the live timeline, walked back down from its live end.
+	TArray<int32, TInlineAllocator<8>> Path;
+	for (int32 Id = BranchId; Id != CurrentId;)
+	{
+		Path.Add(Id);
+		const int32 Index{FindIndex(Id)};
+		check(Index != INDEX_NONE);
+		Id = Branches[Index].ParentId;
+	}
+
+	OutForkTimestamp = MAX_dbl;
+	for (int32 PathIndex = Path.Num() - 1; PathIndex >= 0; --PathIndex)
+	{
+		OutForkTimestamp = FMath::Min(OutForkTimestamp, SwitchToChild(FindIndex(Path[PathIndex]), Actors, Histories));
+	}
+	return true;
+}
+
+double FRewindBranchTree::SwitchToChild(int32 BranchIndex, TConstArrayView<TObjectKey<AActor>> Actors, TArrayView<FActorData> Histories)
+{
+	FRewindBranch Target{MoveTemp(Branches[BranchIndex])};
+	Branches.RemoveAt(BranchIndex);
+	check(Target.ParentId == CurrentId);
+
+	// Only the frames after the fork trade places, the shared ones before it stay where they are.
+	FRewindBranch Previous;
+	Previous.Id = CurrentId;
+	Previous.ParentId = Target.Id;
+	Previous.ForkTimestamp = Target.ForkTimestamp;
+	for (int32 Slot = 0; Slot < Histories.Num(); ++Slot)
+	{
+		auto& Data = Histories[Slot];
+
+		FActorData Suffix;
+		while (Data.HasFrames() && Data.GetFrameTimestamp(Data.NumFrames() - 1) > Target.ForkTimestamp)
+		{
+			Data.MoveTailFrameTo(Suffix);
+		}
+		if (Suffix.HasFrames())
+		{
+			Previous.Suffixes.Add(Actors[Slot], MoveTemp(Suffix));
+		}
+
+		if (auto* TargetSuffix = Target.Suffixes.Find(Actors[Slot]))
+		{
+			while (TargetSuffix->HasFrames() && Data.MoveHeadFrameFrom(*TargetSuffix))
+			{
+			}
+		}
+	}
+
+	// Branches forked off the timeline left behind after this point need the frames it just gave up, the earlier ones
+	// only frames that stay live. The left timeline is kept while any branch needs it, even with nothing of its own.
+	bool bHasChildren{false};
+	for (auto& Other : Branches)
+	{
+		if (Other.ParentId != Previous.Id) continue;
+
+		if (Other.ForkTimestamp <= Target.ForkTimestamp)
+		{
+			Other.ParentId = Target.Id;
+		}
+		else
+		{
+			bHasChildren = true;
+		}
+	}
+	if (bHasChildren || !Previous.Suffixes.IsEmpty())
+	{
+		Branches.Add(MoveTemp(Previous));
+	}
+	CurrentId = Target.Id;
+	return Target.ForkTimestamp;
+}
+
+bool FRewindBranchTree::RemoveOldest()
+{
+	if (Branches.IsEmpty()) return false;
+
+	RemoveWithDescendants(Branches[0].Id);
+	return true;
+}
+
+void FRewindBranchTree::RemoveWithDescendants(int32 BranchId)
+{
+	// A branch can sit before its parent, which took over the live timeline's id only when it forked later.
+	TArray<int32, TInlineAllocator<8>> Removed{BranchId};
+	bool bRemovedAny{true};
+	while (bRemovedAny)
+	{
+		bRemovedAny = false;
+		for (int32 Index = Branches.Num() - 1; Index >= 0; --Index)
+		{
+			if (Removed.Contains(Branches[Index].Id) || Removed.Contains(Branches[Index].ParentId))
+			{
+				Removed.AddUnique(Branches[Index].Id);
+				Branches.RemoveAt(Index);
+				bRemovedAny = true;
+			}
+		}
+	}
+}
+
+int32 FRewindBranchTree::FindIndex(int32 BranchId) const
+{
+	return Branches.IndexOfByPredicate([BranchId](const FRewindBranch& Branch) { return Branch.Id == BranchId; });
+}
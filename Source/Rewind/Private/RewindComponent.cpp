@@ -22,11 +22,36 @@ bool URewindComponent::IsReversingTime() const
 
 FPoseSnapshot URewindComponent::TryGetPose()
 {
-	if (!TargetPose.bIsValid)
+	const auto& Pose{GetPose_AnyThread()};
+	if (!Pose.bIsValid)
 	{
 		UE_LOGFMT(LogRewind,Warning,"Target Pose is not valid.");
 	}
-	return TargetPose;
+	return Pose;
+}
+
+const FPoseSnapshot& URewindComponent::GetPose_AnyThread() const
+{
+	return Poses[FrontPose.load(std::memory_order_acquire)];
+}
+
+FPoseSnapshot& URewindComponent::GetBackPose()
+{
+	bBackPoseWritten = true;
+	return Poses[1 - FrontPose.load(std::memory_order_relaxed)];
+}
+
+int32& URewindComponent::GetBackPoseLayoutId()
+{
+	return PoseLayoutIds[1 - FrontPose.load(std::memory_order_relaxed)];
+}
+
+void URewindComponent::PublishPose()
+{
+	if (!bBackPoseWritten) return;
+
+	bBackPoseWritten = false;
+	FrontPose.store(1 - FrontPose.load(std::memory_order_relaxed), std::memory_order_release);
 }
 void URewindComponent::BeginPlay()
 {
@@ -35,6 +60,13 @@ void URewindComponent::BeginPlay()
 	AddToRewind();
 }
 
+void URewindComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	RemoveFromRewind();
+
+	Super::EndPlay(EndPlayReason);
+}
+
 void URewindComponent::AddToRewind()
 {
 	auto Subsystem{GetWorld()->GetSubsystem<URewindSubsystem>()};
@@ -44,5 +76,14 @@ void URewindComponent::AddToRewind()
 		UE_LOGFMT(LogRewind,Warning,"RewindSubsystem is not valid.");
 		return;
 	}
-	Subsystem->AddActor(GetOwner(),this);
+	Subsystem->RegisterActor(GetOwner(),this);
+}
+
+void URewindComponent::RemoveFromRewind()
+{
+	// The subsystem may already be gone while the world tears down, and then there is nothing to unregister from.
+	if (auto Subsystem{GetWorld()->GetSubsystem<URewindSubsystem>()})
+	{
+		Subsystem->RemoveActor(GetOwner());
+	}
 }
\ No newline at end of file
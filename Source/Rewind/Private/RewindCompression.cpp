@@ -0,0 +1,189 @@
+﻿#include "RewindCompression.h"
+
+#include "RewindTypes.h"
+
+namespace RewindCompression
+{
+	static constexpr float QuatComponentRange{UE_INV_SQRT_2};
+	static constexpr float QuatQuantizationSteps{32767.f};
+
+	static uint16 QuantizeQuatComponent(float Value)
+	{
+		const float Normalized{(FMath::Clamp(Value, -QuatComponentRange, QuatComponentRange) + QuatComponentRange) / (2.f * QuatComponentRange)};
+		return static_cast<uint16>(FMath::RoundToInt32(Normalized * QuatQuantizationSteps));
+	}
+
+	static float DequantizeQuatComponent(uint16 Value)
+	{
+		return (static_cast<float>(Value & 0x7FFF) / QuatQuantizationSteps) * 2.f * QuatComponentRange - QuatComponentRange;
+	}
+
+	static int32 QuantizeToInt32(double Value, float Step)
+	{
+		return static_cast<int32>(FMath::Clamp<double>(FMath::RoundToDouble(Value / Step), MIN_int32, MAX_int32));
+	}
+
+	void PackQuat(const FQuat& InQuat, uint16 Out[3])
+	{
+		FQuat Quat{InQuat.GetNormalized()};
+		const double Components[4]{Quat.X, Quat.Y, Quat.Z, Quat.W};
+
+		int32 LargestIndex{0};
+		for (int32 Index = 1; Index < 4; ++Index)
+		{
+			if (FMath::Abs(Components[Index]) > FMath::Abs(Components[LargestIndex]))
+			{
+				LargestIndex = Index;
+			}
+		}
+
+		// q and -q are the same rotation, so flip the sign to keep the dropped component positive.
+		const double Sign{Components[LargestIndex] < 0.0 ? -1.0 : 1.0};
+
+		int32 OutIndex{0};
+		for (int32 Index = 0; Index < 4; ++Index)
+		{
+			if (Index != LargestIndex)
+			{
+				Out[OutIndex++] = QuantizeQuatComponent(static_cast<float>(Components[Index] * Sign));
+			}
+		}
+
+		// The dropped component's index rides in the spare top bits of the first two words.
+		Out[0] |= (LargestIndex & 1) << 15;
+		Out[1] |= ((LargestIndex >> 1) & 1) << 15;
+	}
+
+	FQuat UnpackQuat(const uint16 In[3])
+	{
+		const int32 LargestIndex{((In[0] >> 15) & 1) | (((In[1] >> 15) & 1) << 1)};
+		const float Small[3]{DequantizeQuatComponent(In[0]), DequantizeQuatComponent(In[1]), DequantizeQuatComponent(In[2])};
+
+		double Components[4];
+		int32 SmallIndex{0};
+		for (int32 Index = 0; Index < 4; ++Index)
+		{
+			if (Index != LargestIndex)
+			{
+				Components[Index] = Small[SmallIndex++];
+			}
+		}
+		Components[LargestIndex] = FMath::Sqrt(FMath::Max(0.f, 1.f - Small[0] * Small[0] - Small[1] * Small[1] - Small[2] * Small[2]));
+
+		return FQuat{Components[0], Components[1], Components[2], Components[3]}.GetNormalized();
+	}
+
+	bool EncodeFrame(const FActorFrameSnapshot& Frame, TConstArrayView<FTransform> Pose, const FVector& Origin, float MaxError,
+		bool bHasScale, FPackedActorFrameSnapshot& OutFrame, TArrayView<uint8> OutPose)
+	{
+		const float Step{2.f * MaxError};
+		const FVector RelativeLocation{Frame.Location - Origin};
+
+		OutFrame.Location[0] = QuantizeToInt32(RelativeLocation.X, Step);
+		OutFrame.Location[1] = QuantizeToInt32(RelativeLocation.Y, Step);
+		OutFrame.Location[2] = QuantizeToInt32(RelativeLocation.Z, Step);
+		PackQuat(Frame.Rotation.Quaternion(), OutFrame.Rotation);
+
+		for (int32 Axis = 0; Axis < 3; ++Axis)
+		{
+			OutFrame.LinearVelocity[Axis] = static_cast<float>(Frame.LinearVelocity[Axis]);
+			OutFrame.AngularVelocity[Axis] = static_cast<float>(Frame.AngularVelocity[Axis]);
+		}
+
+		OutFrame.DeltaTime = Frame.DeltaTime;
+		OutFrame.Timestamp = Frame.Timestamp;
+		OutFrame.PoseLayoutId = Frame.PoseLayoutId;
+		OutFrame.VelocityFlags = (Frame.bHasLinearVelocity ? 1 : 0) | (Frame.bHasAngularVelocity ? 2 : 0);
+		OutFrame.BoneTranslationStep = Step;
+
+		if (Pose.IsEmpty())
+		{
+			return true;
+		}
+
+		check(OutPose.Num() == Pose.Num() * GetPackedBoneSize(bHasScale));
+
+		// Keep the requested error unless a bone sits too far from its parent for int16, then widen the step for this frame only.
+		double MaxTranslation{0.0};
+		for (const FTransform& Transform : Pose)
+		{
+			MaxTranslation = FMath::Max(MaxTranslation, Transform.GetLocation().GetAbsMax());
+		}
+		OutFrame.BoneTranslationStep = FMath::Max(Step, static_cast<float>(MaxTranslation / MAX_int16));
+
+		// Whether a scale is dropped is found while the bones are packed anyway, not in a pass of its own.
+		bool bDroppedScale{false};
+		FPackedBoneTransform* PackedBones{reinterpret_cast<FPackedBoneTransform*>(OutPose.GetData())};
+		for (int32 BoneIndex = 0; BoneIndex < Pose.Num(); ++BoneIndex)
+		{
+			const FTransform& Transform{Pose[BoneIndex]};
+			PackQuat(Transform.GetRotation(), PackedBones[BoneIndex].Rotation);
+			bDroppedScale |= !bHasScale && !Transform.GetScale3D().Equals(FVector::OneVector, UE_KINDA_SMALL_NUMBER);
+
+			const FVector Translation{Transform.GetLocation() / OutFrame.BoneTranslationStep};
+			for (int32 Axis = 0; Axis < 3; ++Axis)
+			{
+				PackedBones[BoneIndex].Translation[Axis] = static_cast<int16>(FMath::Clamp<int32>(FMath::RoundToInt32(Translation[Axis]), MIN_int16, MAX_int16));
+			}
+		}
+
+		if (bHasScale)
+		{
+			FFloat16* PackedScales{reinterpret_cast<FFloat16*>(PackedBones + Pose.Num())};
+			for (int32 BoneIndex = 0; BoneIndex < Pose.Num(); ++BoneIndex)
+			{
+				const FVector Scale{Pose[BoneIndex].GetScale3D()};
+				PackedScales[BoneIndex * 3 + 0] = static_cast<float>(Scale.X);
+				PackedScales[BoneIndex * 3 + 1] = static_cast<float>(Scale.Y);
+				PackedScales[BoneIndex * 3 + 2] = static_cast<float>(Scale.Z);
+			}
+		}
+		return !bDroppedScale;
+	}
+
+	void DecodeFrame(const FPackedActorFrameSnapshot& Frame, const FVector& Origin, float MaxError, FActorFrameSnapshot& OutFrame)
+	{
+		const double Step{2.0 * MaxError};
+
+		OutFrame.Location = Origin + FVector{Frame.Location[0] * Step, Frame.Location[1] * Step, Frame.Location[2] * Step};
+		OutFrame.Rotation = UnpackQuat(Frame.Rotation).Rotator();
+		OutFrame.LinearVelocity = FVector{Frame.LinearVelocity[0].GetFloat(), Frame.LinearVelocity[1].GetFloat(), Frame.LinearVelocity[2].GetFloat()};
+		OutFrame.AngularVelocity = FVector{Frame.AngularVelocity[0].GetFloat(), Frame.AngularVelocity[1].GetFloat(), Frame.AngularVelocity[2].GetFloat()};
+		OutFrame.DeltaTime = Frame.DeltaTime;
+		OutFrame.Timestamp = Frame.Timestamp;
+		OutFrame.PoseLayoutId = Frame.PoseLayoutId;
+		OutFrame.bHasLinearVelocity = (Frame.VelocityFlags & 1) != 0;
+		OutFrame.bHasAngularVelocity = (Frame.VelocityFlags & 2) != 0;
+	}
+
+	void DecodePose(const FPackedActorFrameSnapshot& Frame, TConstArrayView<uint8> Pose, bool bHasScale, TArrayView<FTransform> OutPose)
+	{
+		check(Pose.Num() == OutPose.Num() * GetPackedBoneSize(bHasScale));
+
+		const FPackedBoneTransform* PackedBones{reinterpret_cast<const FPackedBoneTransform*>(Pose.GetData())};
+		const FFloat16* PackedScales{reinterpret_cast<const FFloat16*>(PackedBones + OutPose.Num())};
+		const double Step{Frame.BoneTranslationStep};
+
+		for (int32 BoneIndex = 0; BoneIndex < OutPose.Num(); ++BoneIndex)
+		{
+			const FPackedBoneTransform& Packed{PackedBones[BoneIndex]};
+			OutPose[BoneIndex].SetRotation(UnpackQuat(Packed.Rotation));
+			OutPose[BoneIndex].SetLocation(FVector{Packed.Translation[0] * Step, Packed.Translation[1] * Step, Packed.Translation[2] * Step});
+			OutPose[BoneIndex].SetScale3D(bHasScale
+				? FVector{PackedScales[BoneIndex * 3 + 0].GetFloat(), PackedScales[BoneIndex * 3 + 1].GetFloat(), PackedScales[BoneIndex * 3 + 2].GetFloat()}
+				: FVector::OneVector);
+		}
+	}
+
+	void WidenPose(TConstArrayView<uint8> Pose, int32 NumBones, TArrayView<uint8> OutPose)
+	{
+		check(Pose.Num() == NumBones * GetPackedBoneSize(false) && OutPose.Num() == NumBones * GetPackedBoneSize(true));
+
+		FMemory::Memcpy(OutPose.GetData(), Pose.GetData(), Pose.Num());
+		FFloat16* PackedScales{reinterpret_cast<FFloat16*>(OutPose.GetData() + Pose.Num())};
+		for (int32 Index = 0; Index < NumBones * 3; ++Index)
+		{
+			PackedScales[Index] = 1.f;
+		}
+	}
+}
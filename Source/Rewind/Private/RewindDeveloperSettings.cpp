@@ -13,6 +13,121 @@ float URewindDeveloperSettings::GetRecordedTimeSeconds() const
 	return RecordTime;
 }
 
+float URewindDeveloperSettings::GetExpectedTickRate() const
+{
+	return ExpectedTickRate;
+}
+
+float URewindDeveloperSettings::GetSampleRate() const
+{
+	return SampleRate;
+}
+
+float URewindDeveloperSettings::GetRecordingBudgetMicroseconds() const
+{
+	return RecordingBudgetMicroseconds;
+}
+
+int32 URewindDeveloperSettings::GetMaxTimelineBranches() const
+{
+	return MaxTimelineBranches;
+}
+
+int64 URewindDeveloperSettings::GetHistoryMemoryBudgetBytes() const
+{
+	return HistoryMemoryBudgetBytes;
+}
+
+float URewindDeveloperSettings::GetMaxThinnedFrameInterval() const
+{
+	return MaxThinnedFrameInterval;
+}
+
+float URewindDeveloperSettings::GetMinShortenedRecordTime() const
+{
+	return MinShortenedRecordTime;
+}
+
+bool URewindDeveloperSettings::IsHistorySpillEnabled() const
+{
+	return bSpillHistoryToDisk;
+}
+
+float URewindDeveloperSettings::GetSpillRecordTime() const
+{
+	return SpillRecordTime;
+}
+
+float URewindDeveloperSettings::GetSpillChunkTime() const
+{
+	return SpillChunkTime;
+}
+
+float URewindDeveloperSettings::GetSpillPrefetchTime() const
+{
+	return SpillPrefetchTime;
+}
+
+int64 URewindDeveloperSettings::GetSpillSegmentBytes() const
+{
+	return SpillSegmentBytes;
+}
+
+bool URewindDeveloperSettings::IsRecordingLODEnabled() const
+{
+	return bUseRecordingLOD;
+}
+
+float URewindDeveloperSettings::GetSignificanceInterval() const
+{
+	return SignificanceInterval;
+}
+
+float URewindDeveloperSettings::GetFullFidelityDistance() const
+{
+	return FullFidelityDistance;
+}
+
+float URewindDeveloperSettings::GetReducedFidelityDistance() const
+{
+	return ReducedFidelityDistance;
+}
+
+float URewindDeveloperSettings::GetReducedSampleRate() const
+{
+	return ReducedSampleRate;
+}
+
+float URewindDeveloperSettings::GetMinimalSampleRate() const
+{
+	return MinimalSampleRate;
+}
+
+float URewindDeveloperSettings::GetMinimalRecordTime() const
+{
+	return MinimalRecordTime;
+}
+
+bool URewindDeveloperSettings::IsHistoryIndexEnabled() const
+{
+	return bIndexHistoryForQueries;
+}
+
+float URewindDeveloperSettings::GetHistoryIndexBucketTime() const
+{
+	return HistoryIndexBucketTime;
+}
+
+float URewindDeveloperSettings::GetHistoryIndexCellSize() const
+{
+	return HistoryIndexCellSize;
+}
+
+float URewindDeveloperSettings::GetActorGridCellSize() const
+{
+	return ActorGridCellSize;
+}
+
 TSoftObjectPtr<UCurveFloat> URewindDeveloperSettings::GetRewindCurveFloat() const
 {
 	return RewindCurve;
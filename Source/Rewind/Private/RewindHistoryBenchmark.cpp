@@ -0,0 +1,133 @@
+﻿#include "RewindTypes.h"
+
+#include "Rewind.h"
+#include "HAL/IConsoleManager.h"
+#include "Logging/StructuredLog.h"
+#include "Math/RandomStream.h"
+#include "Misc/AutomationTest.h"
+
+#if !UE_BUILD_SHIPPING
+namespace RewindHistoryBenchmark
+{
+	static constexpr float TickRate{60.f};
+
+	//Actor circling its own center, with the velocities recording would read off its body
+	static FActorFrameSnapshot MakeFrame(const FVector& Center, float Radius, float Speed, double Time, float DeltaTime)
+	{
+		const double Angle{Time * Speed};
+		FActorFrameSnapshot Frame{
+			Center + FVector(FMath::Cos(Angle), FMath::Sin(Angle), 0.0) * Radius,
+			FRotator(0.0, FMath::RadiansToDegrees(Angle) + 90.0, 0.0),
+			FVector(-FMath::Sin(Angle), FMath::Cos(Angle), 0.0) * Radius * Speed,
+			FVector(0.0, 0.0, Speed),
+			DeltaTime
+		};
+		Frame.Timestamp = Time;
+		Frame.bHasLinearVelocity = true;
+		Frame.bHasAngularVelocity = true;
+		return Frame;
+	}
+
+	static void Run(int32 NumActors, ERewindFrameCompression Compression, float Window)
+	{
+		const float DeltaTime{1.f / TickRate};
+		const int32 WindowTicks{FMath::CeilToInt32(Window * TickRate)};
+		FRandomStream Random{NumActors};
+		FRewindScratch Scratch;
+		const FRewindKeyframeReduction Reduction;
+
+		TArray<FActorData> Histories;
+		TArray<FVector> Centers;
+		TArray<float> Speeds;
+		Histories.SetNum(NumActors);
+		for (auto& Data : Histories)
+		{
+			Data.SetCompression(Compression, 0.01f);
+			Data.ReserveFrames(WindowTicks + 1);
+			Centers.Add(Random.VRand() * 10000.f);
+			Speeds.Add(Random.FRandRange(0.5f, 3.f));
+		}
+
+		// Fill the window first, so the timed ticks trim a frame for every one they add like a running game does.
+		double Time{0.0};
+		for (int32 Tick = 0; Tick < WindowTicks; ++Tick)
+		{
+			Time += DeltaTime;
+			for (int32 Actor = 0; Actor < NumActors; ++Actor)
+			{
+				Histories[Actor].RecordFrame(MakeFrame(Centers[Actor], 300.f, Speeds[Actor], Time, DeltaTime), {}, Window, Reduction, Scratch);
+			}
+		}
+
+		double Start{FPlatformTime::Seconds()};
+		for (int32 Tick = 0; Tick < WindowTicks; ++Tick)
+		{
+			Time += DeltaTime;
+			for (int32 Actor = 0; Actor < NumActors; ++Actor)
+			{
+				Histories[Actor].RecordFrame(MakeFrame(Centers[Actor], 300.f, Speeds[Actor], Time, DeltaTime), {}, Window, Reduction, Scratch);
+			}
+		}
+		const double RecordSeconds{FPlatformTime::Seconds() - Start};
+
+		// Rewind at normal speed until every history is down to its last frames.
+		TArray<FRewindPlaybackCursor> Cursors;
+		Cursors.SetNum(NumActors);
+		int32 RewindTicks{0};
+		int64 Interpolated{0};
+		FVector Checksum{FVector::ZeroVector};
+
+		Start = FPlatformTime::Seconds();
+		for (bool bAnyLeft = true; bAnyLeft; ++RewindTicks)
+		{
+			bAnyLeft = false;
+			for (int32 Actor = 0; Actor < NumActors; ++Actor)
+			{
+				auto& Data = Histories[Actor];
+				int32 LeftIndex, RightIndex;
+				float Fraction;
+				bool bExhausted;
+				if (Data.StepPlayback(Cursors[Actor], DeltaTime, LeftIndex, RightIndex, Fraction, bExhausted))
+				{
+					Checksum += InterpolateFrames(Data.GetFrame(RightIndex, Scratch.Frames[0]), Data.GetFrame(LeftIndex, Scratch.Frames[1]), Fraction).Location;
+					++Interpolated;
+				}
+				bAnyLeft |= !bExhausted;
+			}
+		}
+		const double RewindSeconds{FPlatformTime::Seconds() - Start};
+
+		UE_LOGFMT(LogRewind,Display,"{NumActors} actors, {Compression}: record {Record} ms/tick, rewind {Rewind} ms/tick ({Interpolated} interpolations in {Ticks} ticks, checksum {Checksum})",
+			NumActors, Compression == ERewindFrameCompression::None ? TEXT("uncompressed") : TEXT("quantized"),
+			RecordSeconds * 1000.0 / WindowTicks, RewindSeconds * 1000.0 / FMath::Max(RewindTicks, 1), Interpolated, RewindTicks, Checksum.Size());
+	}
+
+	static void Benchmark(const TArray<FString>& Args)
+	{
+		const float Window{Args.Num() > 0 ? FMath::Max(FCString::Atof(*Args[0]), 0.1f) : 5.f};
+
+		for (const int32 NumActors : {100, 1000, 10000})
+		{
+			Run(NumActors, ERewindFrameCompression::None, Window);
+			Run(NumActors, ERewindFrameCompression::Quantized, Window);
+		}
+	}
+
+	static FAutoConsoleCommand BenchmarkCommand(
+		TEXT("Rewind.BenchmarkHistory"),
+		TEXT("Records and rewinds synthetic histories of 100, 1k and 10k actors at 60 Hz, without a world, and reports the cost per tick. Optional argument: recorded seconds (5)."),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&Benchmark));
+}
+
+#if WITH_AUTOMATION_TESTS
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FRewindHistoryBenchmarkTest, "Rewind.History.Benchmark", EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+bool FRewindHistoryBenchmarkTest::RunTest(const FString& Parameters)
+{
+	// The 1k actor case of Rewind.BenchmarkHistory, so every automation run logs comparable timings.
+	RewindHistoryBenchmark::Run(1000, ERewindFrameCompression::None, 5.f);
+	RewindHistoryBenchmark::Run(1000, ERewindFrameCompression::Quantized, 5.f);
+	return true;
+}
+#endif
+#endif
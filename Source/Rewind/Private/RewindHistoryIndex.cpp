@@ -0,0 +1,319 @@
+﻿#include "RewindHistoryIndex.h"
+
+#include "Components/CapsuleComponent.h"
+#include "GameFramework/Character.h"
+
+// Slack for Hermite curves bulging past the bounds of the frames they join, in cm.
+static constexpr double IndexMargin{25.0};
+// A swept box covering more cells than this goes into its buckets' wide sweeps rather than their cells.
+static constexpr int64 MaxSweptCells{512};
+
+void FRewindHistoryIndex::Configure(float InBucketTime, float InCellSize, float InWindow)
+{
+	const float NewBucketTime{FMath::Max(InBucketTime, 0.01f)};
+	const float NewCellSize{FMath::Max(InCellSize, 1.f)};
+	const int32 NumBuckets{FMath::CeilToInt32(FMath::Max(InWindow, 0.f) / NewBucketTime) + 2};
+	if (NewBucketTime == BucketTime && NewCellSize == CellSize && NumBuckets == Buckets.Num()) return;
+
+	BucketTime = NewBucketTime;
+	CellSize = NewCellSize;
+	Buckets.Reset();
+	Buckets.SetNum(NumBuckets);
+}
+
+void FRewindHistoryIndex::Reset()
+{
+	for (auto& Bucket : Buckets)
+	{
+		Bucket.Index = INDEX_NONE;
+		Bucket.Cells.Reset();
+		Bucket.WideSweeps.Reset();
+	}
+}
+
+FIntVector FRewindHistoryIndex::GetCell(const FVector& Location) const
+{
+	return FIntVector{FMath::FloorToInt32(Location.X / CellSize), FMath::FloorToInt32(Location.Y / CellSize), FMath::FloorToInt32(Location.Z / CellSize)};
+}
+
+FRewindHistoryIndex::FBucket* FRewindHistoryIndex::GetBucket(int64 BucketIndex)
+{
+	auto& Bucket = Buckets[static_cast<int32>(((BucketIndex % Buckets.Num()) + Buckets.Num()) % Buckets.Num())];
+	if (Bucket.Index == BucketIndex) return &Bucket;
+	if (Bucket.Index > BucketIndex) return nullptr;
+
+	Bucket.Index = BucketIndex;
+	Bucket.Cells.Reset();
+	Bucket.WideSweeps.Reset();
+	return &Bucket;
+}
+
+void FRewindHistoryIndex::AddFrame(TObjectKey<AActor> InActor, double Timestamp, const FBox& Bounds, FRewindIndexCursor& InOutCursor)
+{
+	check(IsConfigured());
+
+	const bool bHasPrevious{InOutCursor.Bounds.IsValid && InOutCursor.Timestamp <= Timestamp};
+	const FBox Swept{(bHasPrevious ? Bounds + InOutCursor.Bounds : Bounds).ExpandBy(IndexMargin)};
+	const FIntVector MinCell{GetCell(Swept.Min)};
+	const FIntVector MaxCell{GetCell(Swept.Max)};
+	const FIntVector Extent{MaxCell - MinCell + FIntVector(1)};
+
+	// Past the ring the oldest buckets would only be overwritten by the newer ones.
+	const int64 LastBucket{GetBucketIndex(Timestamp)};
+	const int64 FirstBucket{FMath::Max(bHasPrevious ? GetBucketIndex(InOutCursor.Timestamp) : LastBucket, LastBucket - Buckets.Num() + 1)};
+
+	if (static_cast<int64>(Extent.X) * Extent.Y * Extent.Z > MaxSweptCells)
+	{
+		for (int64 BucketIndex = FirstBucket; BucketIndex <= LastBucket; ++BucketIndex)
+		{
+			if (auto* Bucket = GetBucket(BucketIndex))
+			{
+				Bucket->WideSweeps.Emplace(InActor, Swept);
+			}
+		}
+
+		// The cells recorded on the cursor don't hold this sweep, so the next frame is added in full.
+		InOutCursor.Bucket = INDEX_NONE;
+		InOutCursor.Timestamp = Timestamp;
+		InOutCursor.Bounds = Bounds;
+		return;
+	}
+
+	for (int64 BucketIndex = FirstBucket; BucketIndex <= LastBucket; ++BucketIndex)
+	{
+		const bool bSameBucket{BucketIndex == InOutCursor.Bucket};
+		if (bSameBucket && MinCell.X >= InOutCursor.MinCell.X && MinCell.Y >= InOutCursor.MinCell.Y && MinCell.Z >= InOutCursor.MinCell.Z
+			&& MaxCell.X <= InOutCursor.MaxCell.X && MaxCell.Y <= InOutCursor.MaxCell.Y && MaxCell.Z <= InOutCursor.MaxCell.Z)
+		{
+			continue;
+		}
+
+		auto* Bucket = GetBucket(BucketIndex);
+		if (!Bucket) continue;
+
+		for (int32 Z = MinCell.Z; Z <= MaxCell.Z; ++Z)
+		{
+			for (int32 Y = MinCell.Y; Y <= MaxCell.Y; ++Y)
+			{
+				for (int32 X = MinCell.X; X <= MaxCell.X; ++X)
+				{
+					Bucket->Cells.FindOrAdd(FIntVector{X, Y, Z}).AddUnique(InActor);
+				}
+			}
+		}
+
+		if (bSameBucket)
+		{
+			InOutCursor.MinCell = FIntVector{FMath::Min(MinCell.X, InOutCursor.MinCell.X), FMath::Min(MinCell.Y, InOutCursor.MinCell.Y), FMath::Min(MinCell.Z, InOutCursor.MinCell.Z)};
+			InOutCursor.MaxCell = FIntVector{FMath::Max(MaxCell.X, InOutCursor.MaxCell.X), FMath::Max(MaxCell.Y, InOutCursor.MaxCell.Y), FMath::Max(MaxCell.Z, InOutCursor.MaxCell.Z)};
+		}
+		else
+		{
+			InOutCursor.Bucket = BucketIndex;
+			InOutCursor.MinCell = MinCell;
+			InOutCursor.MaxCell = MaxCell;
+		}
+	}
+
+	InOutCursor.Timestamp = Timestamp;
+	InOutCursor.Bounds = Bounds;
+}
+
+void FRewindHistoryIndex::DiscardAfter(double Timestamp)
+{
+	if (!IsConfigured()) return;
+
+	const int64 LastBucket{GetBucketIndex(Timestamp)};
+	for (auto& Bucket : Buckets)
+	{
+		if (Bucket.Index > LastBucket)
+		{
+			Bucket.Index = INDEX_NONE;
+			Bucket.Cells.Reset();
+			Bucket.WideSweeps.Reset();
+		}
+	}
+}
+
+void FRewindHistoryIndex::Gather(double Timestamp, const FBox& QueryBounds, FCandidates& OutCandidates) const
+{
+	if (!IsConfigured()) return;
+
+	const int64 BucketIndex{GetBucketIndex(Timestamp)};
+	const auto& Bucket = Buckets[static_cast<int32>(((BucketIndex % Buckets.Num()) + Buckets.Num()) % Buckets.Num())];
+	if (Bucket.Index != BucketIndex) return;
+
+	const FIntVector MinCell{GetCell(QueryBounds.Min)};
+	const FIntVector MaxCell{GetCell(QueryBounds.Max)};
+	const FIntVector Extent{MaxCell - MinCell + FIntVector(1)};
+
+	const auto AddCandidates = [&OutCandidates](const TArray<TObjectKey<AActor>>& InActors)
+	{
+		for (const auto& Actor : InActors)
+		{
+			OutCandidates.AddUnique(Actor);
+		}
+	};
+
+	for (const auto& WideSweep : Bucket.WideSweeps)
+	{
+		if (WideSweep.Value.Intersect(QueryBounds))
+		{
+			OutCandidates.AddUnique(WideSweep.Key);
+		}
+	}
+
+	// Long traces span more cells than the bucket holds, walking the occupied ones is cheaper then.
+	if (static_cast<int64>(Extent.X) * Extent.Y * Extent.Z > Bucket.Cells.Num())
+	{
+		for (const auto& Cell : Bucket.Cells)
+		{
+			if (Cell.Key.X >= MinCell.X && Cell.Key.Y >= MinCell.Y && Cell.Key.Z >= MinCell.Z
+				&& Cell.Key.X <= MaxCell.X && Cell.Key.Y <= MaxCell.Y && Cell.Key.Z <= MaxCell.Z)
+			{
+				AddCandidates(Cell.Value);
+			}
+		}
+		return;
+	}
+
+	for (int32 Z = MinCell.Z; Z <= MaxCell.Z; ++Z)
+	{
+		for (int32 Y = MinCell.Y; Y <= MaxCell.Y; ++Y)
+		{
+			for (int32 X = MinCell.X; X <= MaxCell.X; ++X)
+			{
+				if (const auto* Cell = Bucket.Cells.Find(FIntVector{X, Y, Z}))
+				{
+					AddCandidates(*Cell);
+				}
+			}
+		}
+	}
+}
+
+namespace RewindHistoryQuery
+{
+	FRewindHistoryShape MakeShape(const AActor* InActor)
+	{
+		FRewindHistoryShape Shape;
+		const auto* Character = Cast<ACharacter>(InActor);
+		if (const auto* Capsule = Character ? Character->GetCapsuleComponent() : nullptr)
+		{
+			Shape.bCapsule = true;
+			Shape.CapsuleRadius = Capsule->GetScaledCapsuleRadius();
+			Shape.CapsuleHalfHeight = FMath::Max(Capsule->GetScaledCapsuleHalfHeight(), Shape.CapsuleRadius);
+			const FVector Extent{Shape.CapsuleRadius, Shape.CapsuleRadius, Shape.CapsuleHalfHeight};
+			Shape.LocalBox = FBox{-Extent, Extent};
+			return Shape;
+		}
+
+		// Frames don't record scale, so the actor's current one is baked into the box.
+		const FBox Box{InActor->CalculateComponentsBoundingBoxInLocalSpace(false)};
+		if (Box.IsValid)
+		{
+			const FVector Scale{InActor->GetActorScale3D().GetAbs()};
+			Shape.LocalBox = FBox{Box.Min * Scale, Box.Max * Scale};
+		}
+		return Shape;
+	}
+
+	//First time along Start + Direction * Time, if any, at which the point is within Radius of Center
+	static bool IntersectSphere(const FVector& Start, const FVector& Direction, const FVector& Center, double Radius, double& OutTime)
+	{
+		const FVector ToStart{Start - Center};
+		const double A{Direction.SizeSquared()};
+		const double B{FVector::DotProduct(Direction, ToStart)};
+		const double C{ToStart.SizeSquared() - Radius * Radius};
+		const double H{B * B - A * C};
+		if (H < 0.0 || A <= UE_DOUBLE_SMALL_NUMBER) return false;
+
+		OutTime = (-B - FMath::Sqrt(H)) / A;
+		return true;
+	}
+
+	static bool SweepSphereBox(const FBox& Box, const FVector& Start, const FVector& End, float Radius, float& OutTime)
+	{
+		// The box grown by the radius, which overestimates the sphere's reach around the corners slightly.
+		const FBox Grown{Box.ExpandBy(Radius)};
+		const FVector Direction{End - Start};
+		double Enter{0.0};
+		double Exit{1.0};
+		for (int32 Axis = 0; Axis < 3; ++Axis)
+		{
+			if (FMath::IsNearlyZero(Direction[Axis]))
+			{
+				if (Start[Axis] < Grown.Min[Axis] || Start[Axis] > Grown.Max[Axis]) return false;
+				continue;
+			}
+
+			double Near{(Grown.Min[Axis] - Start[Axis]) / Direction[Axis]};
+			double Far{(Grown.Max[Axis] - Start[Axis]) / Direction[Axis]};
+			if (Near > Far) Swap(Near, Far);
+			Enter = FMath::Max(Enter, Near);
+			Exit = FMath::Min(Exit, Far);
+			if (Enter > Exit) return false;
+		}
+
+		OutTime = static_cast<float>(Enter);
+		return true;
+	}
+
+	//Capsule along Z centred on the origin. Sweeping a sphere against it is a ray against the capsule grown by the radius.
+	static bool SweepSphereCapsule(float CapsuleRadius, float CapsuleHalfHeight, const FVector& Start, const FVector& End, float Radius, float& OutTime)
+	{
+		const double GrownRadius{static_cast<double>(CapsuleRadius) + Radius};
+		const double HalfSegment{FMath::Max(static_cast<double>(CapsuleHalfHeight) - CapsuleRadius, 0.0)};
+
+		const FVector Axial{0.0, 0.0, FMath::Clamp(Start.Z, -HalfSegment, HalfSegment)};
+		if (FVector::DistSquared(Start, Axial) <= GrownRadius * GrownRadius)
+		{
+			OutTime = 0.f;
+			return true;
+		}
+
+		const FVector Direction{End - Start};
+		double Best{MAX_dbl};
+
+		// Side of the cylinder, in the XY plane, hit between the two cap centres
+		const double A{Direction.X * Direction.X + Direction.Y * Direction.Y};
+		if (A > UE_DOUBLE_SMALL_NUMBER)
+		{
+			const double B{Direction.X * Start.X + Direction.Y * Start.Y};
+			const double C{Start.X * Start.X + Start.Y * Start.Y - GrownRadius * GrownRadius};
+			const double H{B * B - A * C};
+			if (H >= 0.0)
+			{
+				const double Time{(-B - FMath::Sqrt(H)) / A};
+				const double Z{Start.Z + Direction.Z * Time};
+				if (Time >= 0.0 && Z >= -HalfSegment && Z <= HalfSegment)
+				{
+					Best = Time;
+				}
+			}
+		}
+
+		for (const double CapZ : {-HalfSegment, HalfSegment})
+		{
+			double Time;
+			if (IntersectSphere(Start, Direction, FVector{0.0, 0.0, CapZ}, GrownRadius, Time) && Time >= 0.0)
+			{
+				Best = FMath::Min(Best, Time);
+			}
+		}
+
+		if (Best > 1.0) return false;
+		OutTime = static_cast<float>(Best);
+		return true;
+	}
+
+	bool SweepSphere(const FRewindHistoryShape& Shape, const FTransform& Transform, const FVector& Start, const FVector& End, float Radius, float& OutTime)
+	{
+		// Into the actor's space, where the shape is axis aligned. Frames carry no scale, so the distances are unchanged.
+		const FVector LocalStart{Transform.InverseTransformPositionNoScale(Start)};
+		const FVector LocalEnd{Transform.InverseTransformPositionNoScale(End)};
+		return Shape.bCapsule
+			? SweepSphereCapsule(Shape.CapsuleRadius, Shape.CapsuleHalfHeight, LocalStart, LocalEnd, Radius, OutTime)
+			: SweepSphereBox(Shape.LocalBox, LocalStart, LocalEnd, Radius, OutTime);
+	}
+}
@@ -0,0 +1,142 @@
+﻿#include "RewindPoseBlend.h"
+
+#include "Rewind.h"
+#include "HAL/IConsoleManager.h"
+#include "Logging/StructuredLog.h"
+#include "Math/RandomStream.h"
+
+namespace RewindPoseBlend
+{
+	void BlendPoses(TConstArrayView<FTransform> From, TConstArrayView<FTransform> To, float Alpha, TArrayView<FTransform> Out)
+	{
+		check(From.Num() == To.Num() && From.Num() == Out.Num());
+
+		const VectorRegister4Double VAlpha{VectorSetFloat1(static_cast<double>(Alpha))};
+		const VectorRegister4Double VZero{VectorZeroDouble()};
+
+		// Correction of the rotation's blend parameter towards a slerp, from Kapoulkine's fit: Alpha + Cubic * (A * Square + B),
+		// with A and B polynomials of the angle's cosine.
+		const double Cubic{Alpha * (Alpha - 0.5) * (Alpha - 1.0)};
+		const double Square{FMath::Square(Alpha - 0.5)};
+
+		FQuat Rotation;
+		FVector Translation;
+		FVector Scale;
+		for (int32 BoneIndex = 0; BoneIndex < Out.Num(); ++BoneIndex)
+		{
+			const FTransform& A{From[BoneIndex]};
+			const FTransform& B{To[BoneIndex]};
+
+			const FQuat RotationA{A.GetRotation()};
+			const FQuat RotationB{B.GetRotation()};
+			const VectorRegister4Double QA{VectorLoadAligned(&RotationA.X)};
+			VectorRegister4Double QB{VectorLoadAligned(&RotationB.X)};
+			// Flip B onto A's hemisphere so the blend takes the short way round.
+			QB = VectorSelect(VectorCompareGE(VectorDot4(QA, QB), VZero), QB, VectorNegate(QB));
+			const double Cos{FMath::Abs(RotationA | RotationB)};
+			const double FitA{1.0904 + Cos * (-3.2452 + Cos * (3.55645 - Cos * 1.43519))};
+			const double FitB{0.848013 + Cos * (-1.06021 + Cos * 0.215638)};
+			const VectorRegister4Double VRotationAlpha{VectorSetFloat1(Alpha + Cubic * (FitA * Square + FitB))};
+			VectorStoreAligned(VectorNormalizeQuaternion(VectorMultiplyAdd(VectorSubtract(QB, QA), VRotationAlpha, QA)), &Rotation.X);
+
+			const FVector TranslationA{A.GetTranslation()};
+			const FVector TranslationB{B.GetTranslation()};
+			const VectorRegister4Double TA{VectorLoadFloat3_W0(&TranslationA.X)};
+			const VectorRegister4Double TB{VectorLoadFloat3_W0(&TranslationB.X)};
+			VectorStoreFloat3(VectorMultiplyAdd(VectorSubtract(TB, TA), VAlpha, TA), &Translation.X);
+
+			const FVector ScaleA{A.GetScale3D()};
+			const FVector ScaleB{B.GetScale3D()};
+			const VectorRegister4Double SA{VectorLoadFloat3_W0(&ScaleA.X)};
+			const VectorRegister4Double SB{VectorLoadFloat3_W0(&ScaleB.X)};
+			VectorStoreFloat3(VectorMultiplyAdd(VectorSubtract(SB, SA), VAlpha, SA), &Scale.X);
+
+			Out[BoneIndex].SetComponents(Rotation, Translation, Scale);
+		}
+	}
+
+#if !UE_BUILD_SHIPPING
+	//The per-bone blend playback used before the kernel, kept as the baseline it is measured against
+	static void BlendPosesReference(TConstArrayView<FTransform> From, TConstArrayView<FTransform> To, float Alpha, TArrayView<FTransform> Out)
+	{
+		for (int32 i = 0; i < Out.Num(); ++i)
+		{
+			FTransform InterpedTransform;
+			InterpedTransform.SetLocation(FMath::Lerp(From[i].GetLocation(), To[i].GetLocation(), Alpha));
+			InterpedTransform.SetRotation(FQuat::Slerp(From[i].GetRotation(), To[i].GetRotation(), Alpha));
+			InterpedTransform.SetScale3D(FMath::Lerp(From[i].GetScale3D(), To[i].GetScale3D(), Alpha));
+			Out[i] = InterpedTransform;
+		}
+	}
+
+	static void BenchmarkBlendPoses(const TArray<FString>& Args)
+	{
+		const int32 Iterations{Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 20000};
+		FRandomStream Random{0x52574E44};
+
+		for (const int32 NumBones : {30, 70, 150})
+		{
+			// Two poses a frame apart: small turns and moves on top of arbitrary bind poses.
+			TArray<FTransform> From, To, Reference, Kernel;
+			for (int32 BoneIndex = 0; BoneIndex < NumBones; ++BoneIndex)
+			{
+				const FQuat Rotation{FRotator(Random.FRandRange(-180.f, 180.f), Random.FRandRange(-180.f, 180.f), Random.FRandRange(-180.f, 180.f))};
+				const FVector Translation{Random.VRand() * Random.FRandRange(1.f, 50.f)};
+				From.Emplace(Rotation, Translation, FVector::OneVector);
+				To.Emplace(FQuat(Random.VRand(), FMath::DegreesToRadians(Random.FRandRange(0.f, 15.f))) * Rotation, Translation + Random.VRand(), FVector(Random.FRandRange(0.9f, 1.1f)));
+			}
+			Reference.SetNum(NumBones);
+			Kernel.SetNum(NumBones);
+
+			double Start{FPlatformTime::Seconds()};
+			for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+			{
+				BlendPosesReference(From, To, static_cast<float>(Iteration % 64) / 64.f, Reference);
+			}
+			const double ReferenceSeconds{FPlatformTime::Seconds() - Start};
+
+			Start = FPlatformTime::Seconds();
+			for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+			{
+				BlendPoses(From, To, static_cast<float>(Iteration % 64) / 64.f, Kernel);
+			}
+			const double KernelSeconds{FPlatformTime::Seconds() - Start};
+
+			double MaxTranslationError{0.0}, MaxRotationError{0.0}, MaxScaleError{0.0}, MaxWideRotationError{0.0};
+			auto MeasureError = [&Reference, &Kernel](TConstArrayView<FTransform> InFrom, TConstArrayView<FTransform> InTo, double& OutTranslation, double& OutRotation, double& OutScale)
+			{
+				for (const float Alpha : {0.1f, 0.25f, 0.5f, 0.75f, 0.9f})
+				{
+					BlendPosesReference(InFrom, InTo, Alpha, Reference);
+					BlendPoses(InFrom, InTo, Alpha, Kernel);
+					for (int32 BoneIndex = 0; BoneIndex < Kernel.Num(); ++BoneIndex)
+					{
+						OutTranslation = FMath::Max(OutTranslation, FVector::Dist(Reference[BoneIndex].GetTranslation(), Kernel[BoneIndex].GetTranslation()));
+						OutRotation = FMath::Max(OutRotation, FMath::RadiansToDegrees(Reference[BoneIndex].GetRotation().AngularDistance(Kernel[BoneIndex].GetRotation())));
+						OutScale = FMath::Max(OutScale, FVector::Dist(Reference[BoneIndex].GetScale3D(), Kernel[BoneIndex].GetScale3D()));
+					}
+				}
+			};
+			MeasureError(From, To, MaxTranslationError, MaxRotationError, MaxScaleError);
+
+			// The same bones turned up to half a revolution, where an uncorrected nlerp is furthest from the slerp.
+			TArray<FTransform> WideTo{From};
+			for (auto& Transform : WideTo)
+			{
+				Transform.SetRotation(FQuat(Random.VRand(), FMath::DegreesToRadians(Random.FRandRange(90.f, 179.f))) * Transform.GetRotation());
+			}
+			double WideTranslationError{0.0}, WideScaleError{0.0};
+			MeasureError(From, WideTo, WideTranslationError, MaxWideRotationError, WideScaleError);
+
+			UE_LOGFMT(LogRewind,Display,"{NumBones} bones: slerp {Reference} us, kernel {Kernel} us per pose ({Speedup}x). Max error {Translation} cm, {Rotation} deg, {Scale} scale, {WideRotation} deg on turns up to 179 deg.",
+				NumBones, ReferenceSeconds * 1e6 / Iterations, KernelSeconds * 1e6 / Iterations, KernelSeconds > 0.0 ? ReferenceSeconds / KernelSeconds : 0.0,
+				MaxTranslationError, MaxRotationError, MaxScaleError, MaxWideRotationError);
+		}
+	}
+
+	static FAutoConsoleCommand BenchmarkBlendPosesCommand(
+		TEXT("Rewind.BenchmarkPoseBlend"),
+		TEXT("Times the pose blend kernel against the per-bone slerp blend on 30, 70 and 150 bone poses and reports the largest difference between them. Optional argument: iterations."),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkBlendPoses));
+#endif
+}
@@ -0,0 +1,215 @@
+﻿#include "RewindSpillTimeline.h"
+
+#include "Rewind.h"
+#include "Async/Async.h"
+#include "Async/MappedFileHandle.h"
+#include "HAL/PlatformFileManager.h"
+#include "Logging/StructuredLog.h"
+#include "Misc/Paths.h"
+
+FRewindSpillSegmentFile::~FRewindSpillSegmentFile()
+{
+	Writer.Reset();
+	FPlatformFileManager::Get().GetPlatformFile().DeleteFile(*Path);
+}
+
+FRewindMappedChunk::~FRewindMappedChunk()
+{
+	// The region has to go before the file it maps, and the mapping before the file is deleted.
+	Region.Reset();
+	File.Reset();
+	SegmentFile.Reset();
+}
+
+TConstArrayView<uint8> FRewindMappedChunk::GetBytes() const
+{
+	return Region ? TConstArrayView<uint8>(Region->GetMappedPtr(), Region->GetMappedSize()) : TConstArrayView<uint8>();
+}
+
+FRewindSpillTimeline::~FRewindSpillTimeline()
+{
+	Close();
+}
+
+void FRewindSpillTimeline::Open(const FString& InDirectory, int64 InSegmentBytes)
+{
+	Close();
+
+	auto& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	PlatformFile.DeleteDirectoryRecursively(*InDirectory);
+	if (!PlatformFile.CreateDirectoryTree(*InDirectory))
+	{
+		UE_LOGFMT(LogRewind,Warning,"Could not create the rewind spill directory {Directory}",InDirectory);
+		return;
+	}
+
+	Directory = InDirectory;
+	SegmentBytes = FMath::Max<int64>(InSegmentBytes, 1);
+}
+
+void FRewindSpillTimeline::Close()
+{
+	if (!IsOpen()) return;
+
+	if (WriteTask.IsValid())
+	{
+		WriteTask.Wait();
+		WriteTask = TSharedFuture<void>();
+	}
+	PendingWrite.Empty();
+	Segments.Empty();
+	WritingSegment = INDEX_NONE;
+
+	FPlatformFileManager::Get().GetPlatformFile().DeleteDirectoryRecursively(*Directory);
+	Directory.Reset();
+}
+
+void FRewindSpillTimeline::Append(TConstArrayView<uint8> Bytes, FRewindSpilledChunk& InOutChunk)
+{
+	check(IsOpen());
+
+	if (WritingSegment != INDEX_NONE && Segments[WritingSegment].Size > 0 && Segments[WritingSegment].Size + Bytes.Num() > SegmentBytes)
+	{
+		Seal();
+	}
+
+	if (WritingSegment == INDEX_NONE)
+	{
+		WritingSegment = NextSegmentIndex++;
+		auto& NewSegment = Segments.Add(WritingSegment);
+		NewSegment.File = MakeShared<FRewindSpillSegmentFile, ESPMode::ThreadSafe>();
+		NewSegment.File->Path = FPaths::Combine(Directory, FString::Printf(TEXT("Segment_%d.bin"), WritingSegment));
+	}
+
+	auto& Segment = Segments[WritingSegment];
+	InOutChunk.SegmentIndex = WritingSegment;
+	InOutChunk.Offset = Segment.Size;
+	InOutChunk.Size = Bytes.Num();
+
+	PendingWrite.Append(Bytes.GetData(), Bytes.Num());
+	Segment.Size += Bytes.Num();
+	++Segment.NumChunks;
+}
+
+void FRewindSpillTimeline::Flush()
+{
+	if (PendingWrite.IsEmpty() || WritingSegment == INDEX_NONE) return;
+
+	// Appends keep queueing behind a write still running rather than piling up tasks.
+	if (WriteTask.IsValid() && !WriteTask.IsReady()) return;
+
+	StartWrite(false);
+}
+
+void FRewindSpillTimeline::Seal()
+{
+	if (WritingSegment == INDEX_NONE) return;
+
+	StartWrite(true);
+	Segments[WritingSegment].bSealed = true;
+
+	if (Segments[WritingSegment].NumChunks == 0)
+	{
+		DeleteSegment(WritingSegment);
+	}
+	WritingSegment = INDEX_NONE;
+}
+
+void FRewindSpillTimeline::StartWrite(bool bCloseSegment)
+{
+	WriteTask = Async(EAsyncExecution::ThreadPool, [File = Segments[WritingSegment].File, Previous = WriteTask, Bytes = MoveTemp(PendingWrite), bCloseSegment]()
+	{
+		TRACE_CPUPROFILER_EVENT_SCOPE(FRewindSpillTimeline_Write);
+
+		if (Previous.IsValid())
+		{
+			Previous.Wait();
+		}
+
+		auto& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+		if (!File->bOpened)
+		{
+			File->bOpened = true;
+			File->Writer.Reset(PlatformFile.OpenWrite(*File->Path));
+			if (!File->Writer)
+			{
+				UE_LOGFMT(LogRewind,Warning,"Could not open the rewind spill segment {Path}",File->Path);
+			}
+		}
+
+		if (File->Writer && !Bytes.IsEmpty() && !File->Writer->Write(Bytes.GetData(), Bytes.Num()))
+		{
+			UE_LOGFMT(LogRewind,Warning,"Could not write {Num} bytes to the rewind spill segment",Bytes.Num());
+		}
+
+		if (bCloseSegment)
+		{
+			File->Writer.Reset();
+		}
+	}).Share();
+	PendingWrite.Reset();
+}
+
+TFuture<TUniquePtr<FRewindMappedChunk>> FRewindSpillTimeline::Prefetch(const FRewindSpilledChunk& Chunk)
+{
+	if (Chunk.SegmentIndex == WritingSegment)
+	{
+		Seal();
+	}
+
+	const auto* Segment = Segments.Find(Chunk.SegmentIndex);
+	if (!Segment)
+	{
+		return MakeFulfilledPromise<TUniquePtr<FRewindMappedChunk>>().GetFuture();
+	}
+
+	return Async(EAsyncExecution::ThreadPool, [SegmentFile = Segment->File, Written = WriteTask, Offset = Chunk.Offset, Size = Chunk.Size]() -> TUniquePtr<FRewindMappedChunk>
+	{
+		TRACE_CPUPROFILER_EVENT_SCOPE(FRewindSpillTimeline_Prefetch);
+
+		// The chunk is only on disk once the writes queued before it are done.
+		if (Written.IsValid())
+		{
+			Written.Wait();
+		}
+
+		auto Mapped = MakeUnique<FRewindMappedChunk>();
+		Mapped->SegmentFile = SegmentFile;
+		Mapped->File.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*SegmentFile->Path));
+		if (Mapped->File)
+		{
+			Mapped->Region.Reset(Mapped->File->MapRegion(Offset, Size));
+		}
+		if (!Mapped->Region || Mapped->Region->GetMappedSize() != Size)
+		{
+			return nullptr;
+		}
+
+		// Fault the pages in here so the game thread only ever copies from memory.
+		const TConstArrayView<uint8> Bytes{Mapped->GetBytes()};
+		const int32 PageSize{static_cast<int32>(FPlatformMemory::GetConstants().PageSize)};
+		volatile uint8 Touched{0};
+		for (int32 Index = 0; Index < Bytes.Num(); Index += PageSize)
+		{
+			Touched = Touched + Bytes[Index];
+		}
+		return Mapped;
+	});
+}
+
+void FRewindSpillTimeline::Release(const FRewindSpilledChunk& Chunk)
+{
+	auto* Segment = Segments.Find(Chunk.SegmentIndex);
+	if (!Segment) return;
+
+	if (--Segment->NumChunks == 0 && Segment->bSealed)
+	{
+		DeleteSegment(Chunk.SegmentIndex);
+	}
+}
+
+void FRewindSpillTimeline::DeleteSegment(int32 SegmentIndex)
+{
+	// The file itself goes with the last write or mapping still holding it, on whichever thread that is.
+	Segments.Remove(SegmentIndex);
+}
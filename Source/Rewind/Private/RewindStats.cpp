@@ -0,0 +1,31 @@
+﻿#include "RewindStats.h"
+
+DEFINE_STAT(STAT_RewindCapture);
+DEFINE_STAT(STAT_RewindCapturePose);
+DEFINE_STAT(STAT_RewindCaptureBodies);
+DEFINE_STAT(STAT_RewindTrim);
+DEFINE_STAT(STAT_RewindStore);
+DEFINE_STAT(STAT_RewindMemoryBudget);
+DEFINE_STAT(STAT_RewindSpill);
+DEFINE_STAT(STAT_RewindSeek);
+DEFINE_STAT(STAT_RewindInterpolate);
+DEFINE_STAT(STAT_RewindInterpolatePose);
+DEFINE_STAT(STAT_RewindApply);
+DEFINE_STAT(STAT_RewindApplyBodies);
+DEFINE_STAT(STAT_RewindHistoryIndex);
+DEFINE_STAT(STAT_RewindHistoryQuery);
+
+DEFINE_STAT(STAT_RewindFramesRecorded);
+DEFINE_STAT(STAT_RewindFramesInterpolated);
+DEFINE_STAT(STAT_RewindActors);
+DEFINE_STAT(STAT_RewindStoredFrames);
+DEFINE_STAT(STAT_RewindSpilledFrames);
+DEFINE_STAT(STAT_RewindActorsDeferred);
+
+DEFINE_STAT(STAT_RewindHistoryMemory);
+DEFINE_STAT(STAT_RewindPrimitiveMemory);
+DEFINE_STAT(STAT_RewindCharacterMemory);
+DEFINE_STAT(STAT_RewindOtherMemory);
+DEFINE_STAT(STAT_RewindPoseMemory);
+DEFINE_STAT(STAT_RewindBodyMemory);
+DEFINE_STAT(STAT_RewindBranchMemory);
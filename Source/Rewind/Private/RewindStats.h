@@ -0,0 +1,36 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+
+DECLARE_STATS_GROUP(TEXT("Rewind"), STATGROUP_Rewind, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Capture"), STAT_RewindCapture, STATGROUP_Rewind, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Capture Pose"), STAT_RewindCapturePose, STATGROUP_Rewind, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Capture Bodies"), STAT_RewindCaptureBodies, STATGROUP_Rewind, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Trim"), STAT_RewindTrim, STATGROUP_Rewind, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Store"), STAT_RewindStore, STATGROUP_Rewind, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Memory Budget"), STAT_RewindMemoryBudget, STATGROUP_Rewind, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Spill"), STAT_RewindSpill, STATGROUP_Rewind, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Seek"), STAT_RewindSeek, STATGROUP_Rewind, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Interpolate"), STAT_RewindInterpolate, STATGROUP_Rewind, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Interpolate Pose"), STAT_RewindInterpolatePose, STATGROUP_Rewind, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Apply"), STAT_RewindApply, STATGROUP_Rewind, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Apply Bodies"), STAT_RewindApplyBodies, STATGROUP_Rewind, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("History Index"), STAT_RewindHistoryIndex, STATGROUP_Rewind, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("History Query"), STAT_RewindHistoryQuery, STATGROUP_Rewind, );
+
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Frames Recorded"), STAT_RewindFramesRecorded, STATGROUP_Rewind, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Frames Interpolated"), STAT_RewindFramesInterpolated, STATGROUP_Rewind, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Actors"), STAT_RewindActors, STATGROUP_Rewind, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Stored Frames"), STAT_RewindStoredFrames, STATGROUP_Rewind, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Spilled Frames"), STAT_RewindSpilledFrames, STATGROUP_Rewind, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Actors Deferred"), STAT_RewindActorsDeferred, STATGROUP_Rewind, );
+
+DECLARE_MEMORY_STAT_EXTERN(TEXT("History Memory"), STAT_RewindHistoryMemory, STATGROUP_Rewind, );
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Primitive History Memory"), STAT_RewindPrimitiveMemory, STATGROUP_Rewind, );
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Character History Memory"), STAT_RewindCharacterMemory, STATGROUP_Rewind, );
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Other History Memory"), STAT_RewindOtherMemory, STATGROUP_Rewind, );
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Pose Memory"), STAT_RewindPoseMemory, STATGROUP_Rewind, );
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Body Memory"), STAT_RewindBodyMemory, STATGROUP_Rewind, );
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Branch Memory"), STAT_RewindBranchMemory, STATGROUP_Rewind, );
@@ -0,0 +1,451 @@
+﻿#include "RewindSubsystem.h"
+
+#include "Rewind.h"
+#include "RewindComponent.h"
+#include "RewindDeveloperSettings.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Components/StaticMeshComponent.h"
+#include "Containers/Ticker.h"
+#include "Engine/Engine.h"
+#include "Engine/SkeletalMesh.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/StaticMeshActor.h"
+#include "Engine/World.h"
+#include "GameFramework/Character.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "Logging/StructuredLog.h"
+#include "Math/RandomStream.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+#if !UE_BUILD_SHIPPING
+static TAutoConsoleVariable<FString> CVarStressCharacterMesh(
+	TEXT("Rewind.Stress.CharacterMesh"),
+	TEXT(""),
+	TEXT("Skeletal mesh given to the characters Rewind.Stress spawns, so their poses are recorded too. Empty spawns them without one."));
+
+/**
+ * Spawns a population of rewinding actors, records them for a while, rewinds everything and checks they ended up
+ * where they started. Timing and memory go to a CSV so runs can be compared over time.
+ */
+class FRewindStressScenario
+{
+public:
+	struct FParams
+	{
+		int32 NumProps{100};
+		int32 NumCharacters{0};
+		float RecordSeconds{5.f};
+		//Largest distance from its start an actor may end the rewind at, in cm
+		float Tolerance{25.f};
+		//Largest angle from its start rotation an actor may end the rewind at, in degrees
+		float RotationTolerance{5.f};
+		FString CsvPath;
+		//Exit once done, with a non-zero code if the run failed
+		bool bQuit{false};
+		//Told whether the run passed once it is over, or couldn't start
+		TFunction<void(bool)> OnFinished;
+	};
+
+	static void Run(UWorld* InWorld, const FParams& InParams);
+
+	~FRewindStressScenario();
+
+private:
+	enum class EPhase : uint8
+	{
+		Recording,
+		Rewinding
+	};
+
+	FRewindStressScenario(UWorld* InWorld, const FParams& InParams);
+
+	void Spawn();
+	bool Tick(float DeltaTime);
+	void Finish(bool bRewindEnded);
+	void WriteCsv(bool bRewindEnded, bool bPassed, double MaxLocationError, double MaxRotationError) const;
+
+	TWeakObjectPtr<UWorld> World;
+	FParams Params;
+	FTSTicker::FDelegateHandle TickerHandle;
+
+	TArray<TWeakObjectPtr<AActor>> Actors;
+	TArray<FTransform> StartTransforms;
+	//Circle each character is walked around while recording
+	TArray<FVector> CharacterCenters;
+
+	EPhase Phase{EPhase::Recording};
+	float PhaseTime{0.f};
+	int32 RecordFrames{0};
+	double RecordSeconds{0.0};
+	int32 RewindFrames{0};
+	double RewindSeconds{0.0};
+	int64 PeakHistoryBytes{0};
+	double LastTickTime{0.0};
+
+	static TUniquePtr<FRewindStressScenario> Running;
+};
+
+TUniquePtr<FRewindStressScenario> FRewindStressScenario::Running;
+
+void FRewindStressScenario::Run(UWorld* InWorld, const FParams& InParams)
+{
+	if (Running)
+	{
+		UE_LOGFMT(LogRewind,Warning,"A rewind stress run is already in progress.");
+		if (InParams.OnFinished) InParams.OnFinished(false);
+		return;
+	}
+	if (!InWorld || !InWorld->GetSubsystem<URewindSubsystem>())
+	{
+		UE_LOGFMT(LogRewind,Error,"Rewind stress runs need a game world with the rewind subsystem.");
+		if (InParams.OnFinished) InParams.OnFinished(false);
+		return;
+	}
+
+	Running.Reset(new FRewindStressScenario(InWorld, InParams));
+	Running->Spawn();
+}
+
+FRewindStressScenario::FRewindStressScenario(UWorld* InWorld, const FParams& InParams)
+	: World(InWorld)
+	, Params(InParams)
+{
+	// Frames older than the recorded window are gone, and with them the start the actors are checked against.
+	const float RecordedTime{GetDefault<URewindDeveloperSettings>()->GetRecordedTimeSeconds()};
+	if (Params.RecordSeconds >= RecordedTime)
+	{
+		UE_LOGFMT(LogRewind,Warning,"Recording {Seconds}s does not fit the {Window}s window, recording {Clamped}s instead.",Params.RecordSeconds,RecordedTime,RecordedTime * 0.9f);
+		Params.RecordSeconds = RecordedTime * 0.9f;
+	}
+
+	if (Params.CsvPath.IsEmpty())
+	{
+		Params.CsvPath = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("Rewind"), TEXT("Stress.csv"));
+	}
+}
+
+FRewindStressScenario::~FRewindStressScenario()
+{
+	FTSTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+
+	for (const auto& Actor : Actors)
+	{
+		if (Actor.IsValid())
+		{
+			Actor->Destroy();
+		}
+	}
+}
+
+void FRewindStressScenario::Spawn()
+{
+	UWorld* SpawnWorld{World.Get()};
+	FRandomStream Random{Params.NumProps * 7919 + Params.NumCharacters};
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	// Far from whatever the map has, on a grid wide enough that props rarely meet.
+	const FVector Origin{0.0, 0.0, 100000.0};
+	constexpr double Spacing{400.0};
+	const int32 GridSize{FMath::CeilToInt32(FMath::Sqrt(static_cast<float>(Params.NumProps + Params.NumCharacters)))};
+	int32 GridIndex{0};
+	auto NextLocation = [&]()
+	{
+		const FVector Location{Origin + FVector(GridIndex % GridSize, GridIndex / GridSize, 0.0) * Spacing};
+		++GridIndex;
+		return Location;
+	};
+
+	// Weightless props drifting and spinning, so every frame differs from the last.
+	UStaticMesh* PropMesh{LoadObject<UStaticMesh>(nullptr, TEXT("/Engine/BasicShapes/Cube.Cube"))};
+	for (int32 Index = 0; Index < Params.NumProps; ++Index)
+	{
+		auto* Prop{SpawnWorld->SpawnActor<AStaticMeshActor>(NextLocation(), FRotator::ZeroRotator, SpawnParameters)};
+		if (!Prop) continue;
+
+		auto* Mesh{Prop->GetStaticMeshComponent()};
+		Mesh->SetMobility(EComponentMobility::Movable);
+		Mesh->SetStaticMesh(PropMesh);
+		Mesh->SetEnableGravity(false);
+		Mesh->SetSimulatePhysics(true);
+		Mesh->SetPhysicsLinearVelocity(Random.VRand() * Random.FRandRange(50.f, 300.f));
+		Mesh->SetPhysicsAngularVelocityInDegrees(Random.VRand() * Random.FRandRange(10.f, 180.f));
+
+		NewObject<URewindComponent>(Prop)->RegisterComponent();
+		Actors.Add(Prop);
+	}
+
+	USkeletalMesh* CharacterMesh{nullptr};
+	if (!CVarStressCharacterMesh.GetValueOnGameThread().IsEmpty())
+	{
+		CharacterMesh = LoadObject<USkeletalMesh>(nullptr, *CVarStressCharacterMesh.GetValueOnGameThread());
+		if (!CharacterMesh)
+		{
+			UE_LOGFMT(LogRewind,Warning,"Could not load the stress character mesh {Mesh}.",CVarStressCharacterMesh.GetValueOnGameThread());
+		}
+	}
+
+	// Characters are walked around circles by the scenario itself, flying so nothing below them matters.
+	for (int32 Index = 0; Index < Params.NumCharacters; ++Index)
+	{
+		const FVector Center{NextLocation()};
+		auto* Character{SpawnWorld->SpawnActor<ACharacter>(Center, FRotator(0.0, 90.0, 0.0), SpawnParameters)};
+		if (!Character) continue;
+
+		Character->GetCharacterMovement()->SetMovementMode(MOVE_Flying);
+		if (CharacterMesh)
+		{
+			Character->GetMesh()->SetSkeletalMesh(CharacterMesh);
+		}
+
+		NewObject<URewindComponent>(Character)->RegisterComponent();
+		Actors.Add(Character);
+		CharacterCenters.Add(Center);
+	}
+
+	for (const auto& Actor : Actors)
+	{
+		StartTransforms.Add(Actor->GetActorTransform());
+	}
+
+	UE_LOGFMT(LogRewind,Display,"Rewind stress: recording {Props} props and {Characters} characters for {Seconds}s.",Params.NumProps,Params.NumCharacters,Params.RecordSeconds);
+
+	LastTickTime = FPlatformTime::Seconds();
+	TickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FRewindStressScenario::Tick));
+}
+
+bool FRewindStressScenario::Tick(float DeltaTime)
+{
+	auto* Subsystem{World.IsValid() ? World->GetSubsystem<URewindSubsystem>() : nullptr};
+	if (!Subsystem)
+	{
+		UE_LOGFMT(LogRewind,Error,"Rewind stress: the world went away mid run.");
+		const auto OnFinished{MoveTemp(Params.OnFinished)};
+		Running.Reset();
+		if (OnFinished) OnFinished(false);
+		return false;
+	}
+
+	const double Now{FPlatformTime::Seconds()};
+	const double FrameSeconds{Now - LastTickTime};
+	LastTickTime = Now;
+	PhaseTime += DeltaTime;
+
+	if (Phase == EPhase::Recording)
+	{
+		++RecordFrames;
+		RecordSeconds += FrameSeconds;
+
+		const int32 FirstCharacter{Actors.Num() - CharacterCenters.Num()};
+		for (int32 Index = 0; Index < CharacterCenters.Num(); ++Index)
+		{
+			if (AActor* Character{Actors[FirstCharacter + Index].Get()})
+			{
+				const double Angle{PhaseTime * (1.0 + Index % 3)};
+				Character->SetActorLocationAndRotation(CharacterCenters[Index] + FVector(FMath::Cos(Angle) - 1.0, FMath::Sin(Angle), 0.0) * 150.0,
+					FRotator(0.0, FMath::RadiansToDegrees(Angle) + 90.0, 0.0));
+			}
+		}
+
+		if (PhaseTime >= Params.RecordSeconds)
+		{
+			PeakHistoryBytes = Subsystem->GetHistoryMemoryBytes();
+			Phase = EPhase::Rewinding;
+			PhaseTime = 0.f;
+			Subsystem->StartReverse();
+		}
+		return true;
+	}
+
+	// The rewind ends by itself once the histories run dry, a run that outlasts its recording by far never will.
+	if (!Subsystem->IsReversing())
+	{
+		Finish(true);
+		return false;
+	}
+
+	++RewindFrames;
+	RewindSeconds += FrameSeconds;
+
+	if (PhaseTime > Params.RecordSeconds * 4.f + 5.f)
+	{
+		Subsystem->EndReverse();
+		Finish(false);
+		return false;
+	}
+	return true;
+}
+
+void FRewindStressScenario::Finish(bool bRewindEnded)
+{
+	double MaxLocationError{0.0};
+	double MaxRotationError{0.0};
+	for (int32 Index = 0; Index < Actors.Num(); ++Index)
+	{
+		const AActor* Actor{Actors[Index].Get()};
+		if (!Actor) continue;
+
+		MaxLocationError = FMath::Max(MaxLocationError, FVector::Dist(Actor->GetActorLocation(), StartTransforms[Index].GetLocation()));
+		MaxRotationError = FMath::Max(MaxRotationError, FMath::RadiansToDegrees(Actor->GetActorQuat().AngularDistance(StartTransforms[Index].GetRotation())));
+	}
+
+	const bool bPassed{bRewindEnded && MaxLocationError <= Params.Tolerance && MaxRotationError <= Params.RotationTolerance};
+	if (bPassed)
+	{
+		UE_LOGFMT(LogRewind,Display,"Rewind stress passed: actors ended at most {Location}cm and {Rotation}deg from their start.",MaxLocationError,MaxRotationError);
+	}
+	else
+	{
+		UE_LOGFMT(LogRewind,Error,"Rewind stress failed: rewind ended {Ended}, actors ended up to {Location}cm and {Rotation}deg from their start (tolerance {Tolerance}cm and {RotationTolerance}deg).",
+			bRewindEnded,MaxLocationError,MaxRotationError,Params.Tolerance,Params.RotationTolerance);
+	}
+
+	WriteCsv(bRewindEnded, bPassed, MaxLocationError, MaxRotationError);
+
+	const bool bQuit{Params.bQuit};
+	const auto OnFinished{MoveTemp(Params.OnFinished)};
+	Running.Reset();
+
+	if (OnFinished)
+	{
+		OnFinished(bPassed);
+	}
+	if (bQuit)
+	{
+		FPlatformMisc::RequestExitWithStatus(false, bPassed ? 0 : 1);
+	}
+}
+
+void FRewindStressScenario::WriteCsv(bool bRewindEnded, bool bPassed, double MaxLocationError, double MaxRotationError) const
+{
+	FString Csv;
+	if (!FPlatformFileManager::Get().GetPlatformFile().FileExists(*Params.CsvPath))
+	{
+		Csv += TEXT("Date,Props,Characters,RecordSeconds,RecordFrames,RecordMsPerFrame,RewindFrames,RewindMsPerFrame,PeakHistoryBytes,MaxLocationError,MaxRotationError,RewindEnded,Passed\n");
+	}
+	Csv += FString::Printf(TEXT("%s,%d,%d,%.2f,%d,%.3f,%d,%.3f,%lld,%.3f,%.3f,%d,%d\n"),
+		*FDateTime::UtcNow().ToIso8601(), Params.NumProps, Params.NumCharacters, Params.RecordSeconds,
+		RecordFrames, RecordFrames > 0 ? RecordSeconds * 1000.0 / RecordFrames : 0.0,
+		RewindFrames, RewindFrames > 0 ? RewindSeconds * 1000.0 / RewindFrames : 0.0,
+		PeakHistoryBytes, MaxLocationError, MaxRotationError, bRewindEnded ? 1 : 0, bPassed ? 1 : 0);
+
+	if (!FFileHelper::SaveStringToFile(Csv, *Params.CsvPath, FFileHelper::EEncodingOptions::ForceAnsi, &IFileManager::Get(), FILEWRITE_Append))
+	{
+		UE_LOGFMT(LogRewind,Warning,"Could not write the rewind stress results to {Path}.",Params.CsvPath);
+	}
+}
+
+static FAutoConsoleCommandWithWorldAndArgs StressCommand(
+	TEXT("Rewind.Stress"),
+	TEXT("Spawns rewinding actors, records them, rewinds fully and checks they are back where they started. Appends timing and memory to a CSV.\n")
+	TEXT("Rewind.Stress <Props=100> <Characters=0> <Seconds=5> [Tolerance=25] [RotationTolerance=5] [Csv=<Path>] [Quit]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		FRewindStressScenario::FParams Params;
+		TArray<float> Numbers;
+		for (const FString& Arg : Args)
+		{
+			if (Arg.StartsWith(TEXT("Csv=")))
+			{
+				Params.CsvPath = Arg.RightChop(4);
+			}
+			else if (Arg == TEXT("Quit"))
+			{
+				Params.bQuit = true;
+			}
+			else
+			{
+				Numbers.Add(FCString::Atof(*Arg));
+			}
+		}
+
+		if (Numbers.Num() > 0) Params.NumProps = FMath::Max(FMath::RoundToInt32(Numbers[0]), 0);
+		if (Numbers.Num() > 1) Params.NumCharacters = FMath::Max(FMath::RoundToInt32(Numbers[1]), 0);
+		if (Numbers.Num() > 2) Params.RecordSeconds = FMath::Max(Numbers[2], 0.5f);
+		if (Numbers.Num() > 3) Params.Tolerance = FMath::Max(Numbers[3], 0.f);
+		if (Numbers.Num() > 4) Params.RotationTolerance = FMath::Max(Numbers[4], 0.f);
+
+		FRewindStressScenario::Run(World, Params);
+	}));
+
+#if WITH_AUTOMATION_TESTS
+//Runs one stress scenario in the current game world and fails the test unless every actor rewound back to its start
+class FRewindStressLatentCommand : public IAutomationLatentCommand
+{
+public:
+	FRewindStressLatentCommand(FAutomationTestBase& InTest, const FRewindStressScenario::FParams& InParams)
+		: Test(InTest)
+		, Params(InParams)
+	{
+	}
+
+	virtual bool Update() override
+	{
+		if (!bStarted)
+		{
+			bStarted = true;
+
+			UWorld* World{nullptr};
+			for (const FWorldContext& Context : GEngine->GetWorldContexts())
+			{
+				if ((Context.WorldType == EWorldType::Game || Context.WorldType == EWorldType::PIE) && Context.World())
+				{
+					World = Context.World();
+					break;
+				}
+			}
+			if (!World)
+			{
+				Test.AddError(TEXT("Rewind stress tests need a game world. Run them with -game, or while playing in the editor."));
+				return true;
+			}
+
+			Params.OnFinished = [Result = Result](bool bPassed) { *Result = bPassed; };
+			FRewindStressScenario::Run(World, Params);
+		}
+
+		if (!Result->IsSet()) return false;
+
+		Test.TestTrue(TEXT("Every actor rewound back to its start"), Result->GetValue());
+		return true;
+	}
+
+private:
+	FAutomationTestBase& Test;
+	FRewindStressScenario::FParams Params;
+	TSharedRef<TOptional<bool>> Result{MakeShared<TOptional<bool>>()};
+	bool bStarted{false};
+};
+
+IMPLEMENT_COMPLEX_AUTOMATION_TEST(FRewindStressTest, "Rewind.Stress", EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+void FRewindStressTest::GetTests(TArray<FString>& OutBeautifiedNames, TArray<FString>& OutTestCommands) const
+{
+	// Props Characters Seconds, as Rewind.Stress takes them
+	OutBeautifiedNames.Add(TEXT("Props100"));
+	OutTestCommands.Add(TEXT("100 0 3"));
+	OutBeautifiedNames.Add(TEXT("Props1000"));
+	OutTestCommands.Add(TEXT("1000 0 3"));
+	OutBeautifiedNames.Add(TEXT("Characters50"));
+	OutTestCommands.Add(TEXT("0 50 3"));
+}
+
+bool FRewindStressTest::RunTest(const FString& Parameters)
+{
+	TArray<FString> Numbers;
+	Parameters.ParseIntoArrayWS(Numbers);
+
+	FRewindStressScenario::FParams Params;
+	if (Numbers.Num() > 0) Params.NumProps = FMath::Max(FCString::Atoi(*Numbers[0]), 0);
+	if (Numbers.Num() > 1) Params.NumCharacters = FMath::Max(FCString::Atoi(*Numbers[1]), 0);
+	if (Numbers.Num() > 2) Params.RecordSeconds = FMath::Max(FCString::Atof(*Numbers[2]), 0.5f);
+
+	ADD_LATENT_AUTOMATION_COMMAND(FRewindStressLatentCommand(*this, Params));
+	return true;
+}
+#endif
+#endif
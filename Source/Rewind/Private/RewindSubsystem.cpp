@@ -4,21 +4,99 @@
 #include "RewindSubsystem.h"
 
 #include "Rewind.h"
+#include "RewindComponent.h"
 #include "RewindDeveloperSettings.h"
+#include "RewindPoseBlend.h"
+#include "RewindStats.h"
+#include "RewindTimelineFile.h"
+#include "Algo/BinarySearch.h"
 #include "Algo/RemoveIf.h"
+#include "Async/Async.h"
+#include "Async/ParallelFor.h"
 #include "Components/CapsuleComponent.h"
+#include "Components/SkeletalMeshComponent.h"
 #include "Engine/StreamableManager.h"
 #include "GameFramework/Character.h"
+#include "GameFramework/PlayerController.h"
+#include "Engine/SkeletalMesh.h"
+#include "HAL/IConsoleManager.h"
 #include "Logging/StructuredLog.h"
+#include "Misc/FileHelper.h"
+#include "PhysicsEngine/BodyInstance.h"
+#include "Physics/PhysicsInterfaceCore.h"
+#include "Misc/Paths.h"
+#include "ProfilingDebugging/CountersTrace.h"
+#include "Serialization/LargeMemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+TRACE_DECLARE_INT_COUNTER(Rewind_Actors, TEXT("Rewind/Actors"));
+TRACE_DECLARE_INT_COUNTER(Rewind_StoredFrames, TEXT("Rewind/StoredFrames"));
+TRACE_DECLARE_INT_COUNTER(Rewind_SpilledFrames, TEXT("Rewind/SpilledFrames"));
+TRACE_DECLARE_MEMORY_COUNTER(Rewind_HistoryMemory, TEXT("Rewind/HistoryMemory"));
+TRACE_DECLARE_MEMORY_COUNTER(Rewind_PoseMemory, TEXT("Rewind/PoseMemory"));
+
+static FAutoConsoleCommandWithWorldAndArgs DumpTopActorsCommand(
+	TEXT("Rewind.DumpTopActors"),
+	TEXT("Logs the actors with the most history memory. Optional argument: how many (10)."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (const auto* Subsystem{World ? World->GetSubsystem<URewindSubsystem>() : nullptr})
+		{
+			Subsystem->DumpTopActors(Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 10);
+		}
+	}));
+
+URewindSubsystem::FRegistryIterationScope::FRegistryIterationScope(URewindSubsystem& InSubsystem)
+	: Subsystem(InSubsystem)
+	, bOutermost(!InSubsystem.bIteratingRegistry)
+{
+	Subsystem.bIteratingRegistry = true;
+}
+
+URewindSubsystem::FRegistryIterationScope::~FRegistryIterationScope()
+{
+	if (bOutermost)
+	{
+		Subsystem.bIteratingRegistry = false;
+		Subsystem.RemovePendingActors();
+	}
+}
 
 void URewindSubsystem::AddActor(AActor* InActor,URewindComponent* InComponent)
 {
-	ReverseActors.Emplace(FRewindActor{InActor,InComponent});
+	RegisterActor(InActor, InComponent);
+}
+
+void URewindSubsystem::RegisterActor(AActor* InActor,URewindComponent* InComponent)
+{
+	if (!IsValid(InActor) || !IsValid(InComponent)) return;
+
+	// The registry keeps the actor and component until the component's EndPlay takes them out again.
+	if (InComponent->GetOwner() != InActor)
+	{
+		UE_LOGFMT(LogRewind,Warning,"{Component} is not owned by {Actor}, which is not added to rewind",InComponent->GetFName(),InActor->GetFName());
+		return;
+	}
+
+	Registry.Add(InActor, InComponent);
 }
 
 void URewindSubsystem::RemoveActor(AActor* InActor)
 {
-	PendingRemoveActors.Emplace(InActor);
+	if (!InActor) return;
+
+	if (bIteratingRegistry)
+	{
+		PendingRemoveActors.Emplace(InActor);
+		return;
+	}
+
+	const int32 Slot{Registry.Find(InActor)};
+	if (Slot != INDEX_NONE)
+	{
+		RemoveSlot(Slot);
+		UE_LOGFMT(LogRewind,Verbose,"Removed {Actor} from rewind",InActor->GetFName());
+	}
 }
 
 bool URewindSubsystem::IsReversing() const
@@ -31,6 +109,339 @@ void URewindSubsystem::SetRewindConfig(const FRewindConfig& InRewindConfig)
 	RewindConfig = InRewindConfig;
 }
 
+bool URewindSubsystem::SampleAt(AActor* InActor, float TimeAgo, FRewindSample& OutSample)
+{
+	const int32 Slot{Registry.Find(InActor)};
+	if (Slot == INDEX_NONE) return false;
+
+	const auto* Data = &Registry.Histories[Slot];
+	int32 LeftIndex, RightIndex;
+	float Fraction;
+	if (!Data->FindBracket(RecordingClock - FMath::Max(TimeAgo, 0.f), LeftIndex, RightIndex, Fraction))
+	{
+		return false;
+	}
+
+	const auto Interpolated{InterpolateFrames(Data->GetFrame(RightIndex, GameThreadScratch.Frames[0]), Data->GetFrame(LeftIndex, GameThreadScratch.Frames[1]), Fraction)};
+	OutSample.Location = Interpolated.Location;
+	OutSample.Rotation = Interpolated.Rotation;
+	OutSample.LinearVelocity = Interpolated.LinearVelocity;
+	OutSample.AngularVelocity = Interpolated.AngularVelocity;
+	return true;
+}
+
+double URewindSubsystem::GetRecordingClock() const
+{
+	return RecordingClock;
+}
+
+bool URewindSubsystem::SweepHistory(double Timestamp, const FVector& Start, const FVector& End, float Radius, TArray<FRewindHistoryHit>& OutHits) const
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(URewindSubsystem_SweepHistory);
+	SCOPE_CYCLE_COUNTER(STAT_RewindHistoryQuery);
+
+	OutHits.Reset();
+	Radius = FMath::Max(Radius, 0.f);
+
+	FRewindHistoryHit Hit;
+	if (HistoryIndex.IsConfigured() && GetDefault<URewindDeveloperSettings>()->IsHistoryIndexEnabled())
+	{
+		FRewindHistoryIndex::FCandidates Candidates;
+		HistoryIndex.Gather(Timestamp, FBox{Start.ComponentMin(End), Start.ComponentMax(End)}.ExpandBy(Radius), Candidates);
+		for (const auto& Candidate : Candidates)
+		{
+			const int32 Slot{Registry.Find(Candidate)};
+			if (Slot != INDEX_NONE && SweepSlot(Slot, Timestamp, Start, End, Radius, Hit))
+			{
+				OutHits.Add(Hit);
+			}
+		}
+	}
+	else
+	{
+		for (int32 Slot = 0; Slot < Registry.Num(); ++Slot)
+		{
+			if (SweepSlot(Slot, Timestamp, Start, End, Radius, Hit))
+			{
+				OutHits.Add(Hit);
+			}
+		}
+	}
+
+	OutHits.Sort([](const FRewindHistoryHit& A, const FRewindHistoryHit& B) { return A.Distance < B.Distance; });
+	return !OutHits.IsEmpty();
+}
+
+bool URewindSubsystem::SweepActorHistory(AActor* InActor, double Timestamp, const FVector& Start, const FVector& End, float Radius, FRewindHistoryHit& OutHit) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_RewindHistoryQuery);
+
+	const int32 Slot{Registry.Find(InActor)};
+	return Slot != INDEX_NONE && SweepSlot(Slot, Timestamp, Start, End, FMath::Max(Radius, 0.f), OutHit);
+}
+
+bool URewindSubsystem::SweepSlot(int32 Slot, double Timestamp, const FVector& Start, const FVector& End, float Radius, FRewindHistoryHit& OutHit) const
+{
+	const auto& Data = Registry.Histories[Slot];
+	// Lag compensation can't reach past the history in memory, clamping to its oldest frame would be a guess.
+	if (!Data.HasFrames() || Timestamp < Data.GetFrameTimestamp(0)) return false;
+
+	int32 LeftIndex, RightIndex;
+	float Fraction;
+	if (!Data.FindBracket(Timestamp, LeftIndex, RightIndex, Fraction)) return false;
+
+	// Decoded on the stack, so queries neither allocate nor share scratch.
+	FActorFrameSnapshot Frames[2];
+	const auto State{InterpolateFrames(Data.GetFrame(RightIndex, Frames[0]), Data.GetFrame(LeftIndex, Frames[1]), Fraction)};
+
+	float Time;
+	if (!RewindHistoryQuery::SweepSphere(Registry.Shapes[Slot], FTransform{State.Rotation, State.Location}, Start, End, Radius, Time)) return false;
+
+	OutHit.Actor = Registry.Actors[Slot];
+	OutHit.ImpactPoint = FMath::Lerp(Start, End, static_cast<double>(Time));
+	OutHit.Distance = static_cast<float>(FVector::Dist(Start, OutHit.ImpactPoint));
+	OutHit.ActorLocation = State.Location;
+	OutHit.ActorRotation = State.Rotation;
+	return true;
+}
+
+void URewindSubsystem::SeekTo(float TimeAgo)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(URewindSubsystem_Seek);
+	SCOPE_CYCLE_COUNTER(STAT_RewindSeek);
+
+	// Reverse playback consumes the history it walks, so the two can't run together.
+	if (bRewindingTime) return;
+
+	FRegistryIterationScope IterationScope{*this};
+
+	if (!bSeeking)
+	{
+		EndAllGroups();
+		bSeeking = true;
+		for (int32 Slot = 0; Slot < Registry.Num(); ++Slot)
+		{
+			Registry.Components[Slot]->bReversingTime = true;
+		}
+	}
+
+	const double Time{RecordingClock - FMath::Max(TimeAgo, 0.f)};
+
+	for (int32 Slot = 0; Slot < Registry.Num(); ++Slot)
+	{
+		const auto& Data = Registry.Histories[Slot];
+		int32 LeftIndex, RightIndex;
+		float Fraction;
+		if (!Data.FindBracket(Time, LeftIndex, RightIndex, Fraction)) continue;
+
+		const auto Interpolated{InterpolateFrames(Data.GetFrame(RightIndex, GameThreadScratch.Frames[0]), Data.GetFrame(LeftIndex, GameThreadScratch.Frames[1]), Fraction)};
+
+		if (Registry.Kinds[Slot] == ERewindActorKind::Character)
+		{
+			InterpTargetPose(*Registry.Components[Slot], Data, RightIndex, LeftIndex, Fraction, GameThreadScratch);
+			Registry.Components[Slot]->PublishPose();
+		}
+
+		ApplySnapshot(Slot, Interpolated);
+		if (SampleBodies(Slot, Time))
+		{
+			ApplyBodies(Slot);
+		}
+	}
+}
+
+void URewindSubsystem::EndSeek()
+{
+	if (!bSeeking) return;
+
+	SeekTo(0.f);
+	bSeeking = false;
+
+	FRegistryIterationScope IterationScope{*this};
+
+	for (int32 Slot = 0; Slot < Registry.Num(); ++Slot)
+	{
+		Registry.Components[Slot]->bReversingTime = false;
+	}
+}
+
+bool URewindSubsystem::IsSeeking() const
+{
+	return bSeeking;
+}
+
+int64 URewindSubsystem::GetHistoryMemoryBytes() const
+{
+	int64 TotalBytes{BranchTree.GetMemoryBytes()};
+	for (int32 Slot = 0; Slot < Registry.Num(); ++Slot)
+	{
+		TotalBytes += Registry.Histories[Slot].GetMemoryBytes();
+		TotalBytes += Registry.Futures[Slot].GetMemoryBytes();
+		TotalBytes += Registry.BodyHistories[Slot].GetMemoryBytes();
+	}
+	return TotalBytes;
+}
+
+int64 URewindSubsystem::GetActorHistoryMemoryBytes(AActor* InActor) const
+{
+	const int32 Slot{Registry.Find(InActor)};
+	return Slot != INDEX_NONE ? Registry.Histories[Slot].GetMemoryBytes() : 0;
+}
+
+bool URewindSubsystem::SaveTimeline(const FString& Filename)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(URewindSubsystem_SaveTimeline);
+
+	if (IsSavingTimeline()) return false;
+
+	auto Header{RewindTimelineFile::MakeHeader()};
+	Header.RecordingClock = RecordingClock;
+	Header.Layouts = BoneLayouts;
+	Header.Actors.Reserve(Registry.Num());
+
+	int64 PayloadSize{0};
+	for (int32 Slot = 0; Slot < Registry.Num(); ++Slot)
+	{
+		const auto& Data = Registry.Histories[Slot];
+		auto& Entry = Header.Actors.AddDefaulted_GetRef();
+		Entry.ActorPath = Registry.Actors[Slot]->GetPathName();
+		Entry.Format = Data.GetFormat();
+		Entry.PoseLayoutId = Data.PoseLayoutId;
+		Entry.NumFrames = Data.NumFrames();
+		Entry.Offset = PayloadSize;
+		Entry.Size = Data.NumFrames() * Data.GetFrameBytes();
+		PayloadSize += Entry.Size;
+	}
+
+	TArray64<uint8> Bytes;
+	FMemoryWriter64 Writer{Bytes};
+	RewindTimelineFile::SerializeHeader(Writer, Header);
+	const int64 PayloadStart{Bytes.Num()};
+	Bytes.AddUninitialized(PayloadSize);
+
+	// Histories are copied straight into the file image, a plain memcpy each.
+	ParallelFor(Registry.Num(), [this, &Header, &Bytes, PayloadStart](int32 Slot)
+	{
+		Registry.Histories[Slot].CopyHeadFrames(Header.Actors[Slot].NumFrames, Bytes.GetData() + PayloadStart + Header.Actors[Slot].Offset);
+	});
+
+	PendingTimelineSave = Async(EAsyncExecution::ThreadPool, [Bytes = MoveTemp(Bytes), Filename]()
+	{
+		TRACE_CPUPROFILER_EVENT_SCOPE(URewindSubsystem_WriteTimeline);
+
+		if (!FFileHelper::SaveArrayToFile(Bytes, *Filename))
+		{
+			UE_LOGFMT(LogRewind,Warning,"Could not write the rewind timeline to {File}",Filename);
+			return false;
+		}
+		return true;
+	});
+	return true;
+}
+
+bool URewindSubsystem::LoadTimeline(const FString& Filename)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(URewindSubsystem_LoadTimeline);
+
+	if (bRewindingTime || bSeeking) return false;
+
+	EndAllGroups();
+
+	TArray64<uint8> Bytes;
+	if (!FFileHelper::LoadFileToArray(Bytes, *Filename))
+	{
+		UE_LOGFMT(LogRewind,Warning,"Could not read a rewind timeline from {File}",Filename);
+		return false;
+	}
+
+	FRewindTimelineHeader Header;
+	FLargeMemoryReader Reader{Bytes.GetData(), Bytes.Num()};
+	RewindTimelineFile::SerializeHeader(Reader, Header);
+	if (Reader.IsError() || !RewindTimelineFile::IsValid(Header, Bytes.Num() - Reader.Tell()))
+	{
+		UE_LOGFMT(LogRewind,Warning,"{File} is not a rewind timeline this build can read",Filename);
+		return false;
+	}
+	const int64 PayloadStart{Reader.Tell()};
+
+	// Saved layouts join the table, sharing the entry of a mesh with the same bones.
+	TArray<int32> LayoutIdMap;
+	LayoutIdMap.Reserve(Header.Layouts.Num());
+	for (auto& Layout : Header.Layouts)
+	{
+		int32 LayoutId{BoneLayouts.IndexOfByPredicate([&Layout](const FRewindBoneLayout& Existing)
+		{
+			return Existing.SkeletalMeshName == Layout.SkeletalMeshName && Existing.BoneNames == Layout.BoneNames && Existing.ParentIndices == Layout.ParentIndices;
+		})};
+		if (LayoutId == INDEX_NONE)
+		{
+			LayoutId = BoneLayouts.Add(MoveTemp(Layout));
+		}
+		LayoutIdMap.Add(LayoutId);
+	}
+
+	TMap<FString, int32> SlotByPath;
+	SlotByPath.Reserve(Registry.Num());
+	for (int32 Slot = 0; Slot < Registry.Num(); ++Slot)
+	{
+		SlotByPath.Add(Registry.Actors[Slot]->GetPathName(), Slot);
+		Registry.Histories[Slot].ResetFrames();
+		Registry.Futures[Slot].ResetFrames();
+		Registry.BodyHistories[Slot].Reset();
+		Registry.RecordedTimeLimits[Slot] = MAX_flt;
+		DiscardSpilledFrames(Slot);
+	}
+
+	int32 NumLoaded{0};
+	for (const auto& Entry : Header.Actors)
+	{
+		const int32* Slot = SlotByPath.Find(Entry.ActorPath);
+		if (!Slot || Entry.Size > MAX_int32) continue;
+
+		// One bulk copy into the history's frame store, no per-frame decoding.
+		auto& Data = Registry.Histories[*Slot];
+		if (!Data.RestoreFrames(Entry.Format, TConstArrayView<uint8>(Bytes.GetData() + PayloadStart + Entry.Offset, static_cast<int32>(Entry.Size)), Entry.NumFrames))
+		{
+			Data.ResetFrames();
+			continue;
+		}
+
+		Data.RemapPoseLayoutIds(LayoutIdMap);
+		Data.PoseLayoutId = LayoutIdMap.IsValidIndex(Entry.PoseLayoutId) ? LayoutIdMap[Entry.PoseLayoutId] : INDEX_NONE;
+		Registry.OutOfData[*Slot] = false;
+		++NumLoaded;
+	}
+
+	RecordingClock = Header.RecordingClock;
+	SampleAccumulator = 0.f;
+	BranchTree.Reset();
+	HistoryIndex.Reset();
+	for (auto& Cursor : Registry.IndexCursors)
+	{
+		Cursor = FRewindIndexCursor();
+	}
+	if (HistoryIndex.IsConfigured())
+	{
+		for (int32 Slot = 0; Slot < Registry.Num(); ++Slot)
+		{
+			const auto& Data = Registry.Histories[Slot];
+			for (int32 Index = 0; Index < Data.NumFrames(); ++Index)
+			{
+				const auto& Frame = Data.GetFrame(Index, GameThreadScratch.Frames[0]);
+				HistoryIndex.AddFrame(Registry.Actors[Slot], Frame.Timestamp, Registry.Shapes[Slot].GetWorldBounds(FTransform{Frame.Rotation, Frame.Location}), Registry.IndexCursors[Slot]);
+			}
+		}
+	}
+
+	UE_LOGFMT(LogRewind,Log,"Loaded {Num} of {Total} actor histories from {File}",NumLoaded,Header.Actors.Num(),Filename);
+	return true;
+}
+
+bool URewindSubsystem::IsSavingTimeline() const
+{
+	return PendingTimelineSave.IsValid() && !PendingTimelineSave.IsReady();
+}
+
 void URewindSubsystem::Initialize(FSubsystemCollectionBase& Collection)
 {
 	Super::Initialize(Collection);
@@ -45,6 +456,7 @@ void URewindSubsystem::Initialize(FSubsystemCollectionBase& Collection)
 	if (!CurveToLoad)
 	{
 		RewindConfig=FRewindConfig{Settings->GetRewindSpeed(),Settings->GetRewindSpeed()};
+		RewindConfig.SampleRate=Settings->GetSampleRate();
 		return;
 	}
 	
@@ -55,6 +467,7 @@ void URewindSubsystem::Initialize(FSubsystemCollectionBase& Collection)
 		auto Settings{GetDefault<URewindDeveloperSettings>()};
 		
 		RewindConfig=FRewindConfig{Settings->GetRewindSpeed(),Settings->GetRewindSpeed(),Settings->GetRewindCurveFloat().Get()};
+		RewindConfig.SampleRate=Settings->GetSampleRate();
 	});
 	
 }
@@ -67,352 +480,1419 @@ void URewindSubsystem::Tick(float DeltaTime)
 
 	TRACE_CPUPROFILER_EVENT_SCOPE(URewindSubsystem_Tick);
 
-	
-    
-	if (ReverseActors.IsEmpty()) return;
+	if (Registry.IsEmpty()) return;
 
-	// ----- STEP 1: Create Snapshot (reuse variable) -----
-	FActorFrameSnapshot Snapshot{};
-	
-	RemovePendingKillActorsOrRequested();
+	FRegistryIterationScope IterationScope{*this};
+
+	// Scrubbing holds the actors on the sampled time until EndSeek.
+	if (bSeeking) return;
 	
 	if (!bRewindingTime)
 	{
 		// -----  Handle Forward Recording -----
-		HandleForwardRecording(DeltaTime, Snapshot);
+		// With a sample rate set, frames are taken at that rate and each covers the real time since the previous one.
+		SampleAccumulator += DeltaTime;
+		if (RewindConfig.SampleRate <= 0.f || SampleAccumulator * RewindConfig.SampleRate >= 1.f)
+		{
+			HandleForwardRecording(SampleAccumulator);
+			SampleAccumulator = 0.f;
+		}
+
+		// Groups play back on their own clocks meanwhile. Ending a group removes it, so they are walked from the back.
+		for (int32 GroupIndex = Groups.Num() - 1; GroupIndex >= 0; --GroupIndex)
+		{
+			if (Groups.IsValidIndex(GroupIndex))
+			{
+				HandleGroupPlayback(GroupIndex, DeltaTime);
+			}
+		}
 	}
 	else
 	{
 		// ----- OR : Handle Reverse Playback -----
 		HandleReversePlayback(DeltaTime);
 	}
-}
 
-void URewindSubsystem::Deinitialize()
-{
-	Super::Deinitialize();
+	UpdateStats();
 }
 
-void URewindSubsystem::SetSnapshotVariables(AActor* InActor, const FVector& SnapshotLocation,
-	const FRotator& SnapshotRotation, const FVector& SnapshotLinearVelocity, const FVector& SnapshotAngularVelocity)
+void URewindSubsystem::UpdateStats() const
 {
-	InActor->SetActorLocation(SnapshotLocation);
-	InActor->SetActorRotation(SnapshotRotation);
-
-	if (auto* MeshRoot = Cast<UPrimitiveComponent>(InActor->GetRootComponent()))
+#if STATS || COUNTERSTRACE_ENABLED
+	int64 KindBytes[3]{};
+	int64 PoseBytes{0};
+	int64 BodyBytes{0};
+	int64 BranchBytes{0};
+	int64 StoredFrames{0};
+	int64 SpilledFrames{0};
+	for (int32 Slot = 0; Slot < Registry.Num(); ++Slot)
 	{
-		MeshRoot->SetPhysicsLinearVelocity(SnapshotLinearVelocity);
-		MeshRoot->SetPhysicsAngularVelocityInRadians(SnapshotAngularVelocity);
+		const auto& Data = Registry.Histories[Slot];
+		KindBytes[static_cast<int32>(Registry.Kinds[Slot])] += Data.GetMemoryBytes();
+		PoseBytes += Data.GetPoseMemoryBytes();
+		BodyBytes += Registry.BodyHistories[Slot].GetMemoryBytes();
+		BranchBytes += Registry.Futures[Slot].GetMemoryBytes();
+		StoredFrames += Data.NumFrames();
+		SpilledFrames += Registry.Spills[Slot].NumFrames;
 	}
-	
+	BranchBytes += BranchTree.GetMemoryBytes();
+	const int64 TotalBytes{KindBytes[0] + KindBytes[1] + KindBytes[2]};
+
+	SET_DWORD_STAT(STAT_RewindActors, Registry.Num());
+	SET_DWORD_STAT(STAT_RewindStoredFrames, StoredFrames);
+	SET_DWORD_STAT(STAT_RewindSpilledFrames, SpilledFrames);
+	SET_MEMORY_STAT(STAT_RewindHistoryMemory, TotalBytes);
+	SET_MEMORY_STAT(STAT_RewindPrimitiveMemory, KindBytes[static_cast<int32>(ERewindActorKind::Primitive)]);
+	SET_MEMORY_STAT(STAT_RewindCharacterMemory, KindBytes[static_cast<int32>(ERewindActorKind::Character)]);
+	SET_MEMORY_STAT(STAT_RewindOtherMemory, KindBytes[static_cast<int32>(ERewindActorKind::Other)]);
+	SET_MEMORY_STAT(STAT_RewindPoseMemory, PoseBytes);
+	SET_MEMORY_STAT(STAT_RewindBodyMemory, BodyBytes);
+	SET_MEMORY_STAT(STAT_RewindBranchMemory, BranchBytes);
+
+	TRACE_COUNTER_SET(Rewind_Actors, Registry.Num());
+	TRACE_COUNTER_SET(Rewind_StoredFrames, StoredFrames);
+	TRACE_COUNTER_SET(Rewind_SpilledFrames, SpilledFrames);
+	TRACE_COUNTER_SET(Rewind_HistoryMemory, TotalBytes);
+	TRACE_COUNTER_SET(Rewind_PoseMemory, PoseBytes);
+#endif
 }
 
-FPoseSnapshot URewindSubsystem::InterpPoseSnapshotTo(const FPoseSnapshot& Current, const FPoseSnapshot& Target,
-	float DeltaTime, float InterpSpeed)
+void URewindSubsystem::DumpTopActors(int32 Count) const
 {
-	FPoseSnapshot Result;
-
-	// Sanity checks
-	if (!Current.bIsValid || !Target.bIsValid)
+	TArray<int32> Slots;
+	Slots.Reserve(Registry.Num());
+	for (int32 Slot = 0; Slot < Registry.Num(); ++Slot)
 	{
-		return Result; // bIsValid false by default
+		Slots.Add(Slot);
 	}
+	Slots.Sort([this](int32 A, int32 B) { return Registry.Histories[A].GetMemoryBytes() > Registry.Histories[B].GetMemoryBytes(); });
 
-	if (Current.BoneNames.Num() != Target.BoneNames.Num() || Current.LocalTransforms.Num() != Target.LocalTransforms.Num())
-	{
-		return Result;
-	}
+	UE_LOGFMT(LogRewind,Display,"{Num} actors recording, {Bytes} bytes of history in memory",Registry.Num(),GetHistoryMemoryBytes());
 
-	const int32 NumBones = Current.BoneNames.Num();
-	for (int32 i = 0; i < NumBones; ++i)
+	for (int32 Rank = 0; Rank < FMath::Min(Count, Slots.Num()); ++Rank)
 	{
-		if (Current.BoneNames[i] != Target.BoneNames[i])
+		const int32 Slot{Slots[Rank]};
+		const auto& Data = Registry.Histories[Slot];
+		const auto& Spill = Registry.Spills[Slot];
+
+		int64 SpilledBytes{0};
+		for (const auto& Chunk : Spill.Chunks)
 		{
-			return Result;
+			SpilledBytes += Chunk.Size;
 		}
 
-		const FTransform& CurrentTransform = Current.LocalTransforms[i];
-		const FTransform& TargetTransform = Target.LocalTransforms[i];
+		const TCHAR* Kind{Registry.Kinds[Slot] == ERewindActorKind::Primitive ? TEXT("Primitive") : Registry.Kinds[Slot] == ERewindActorKind::Character ? TEXT("Character") : TEXT("Other")};
+		const TCHAR* LOD{Registry.RecordingLODs[Slot] == ERewindRecordingLOD::Full ? TEXT("full") : Registry.RecordingLODs[Slot] == ERewindRecordingLOD::Reduced ? TEXT("reduced") : TEXT("minimal")};
+		UE_LOGFMT(LogRewind,Display,"{Rank}. {Actor} ({Kind}, {LOD} fidelity{Compressed}): {Bytes} bytes, {PoseBytes} of them poses, {Frames} frames over {Time}s. {SpilledFrames} frames, {SpilledBytes} bytes on disk.",
+			Rank + 1, GetNameSafe(Registry.Actors[Slot]), Kind, LOD, Data.IsCompressed() ? TEXT(", quantized") : TEXT(""),
+			Data.GetMemoryBytes(), Data.GetPoseMemoryBytes(), Data.NumFrames(), Data.GetRecordedTime(), Spill.NumFrames, SpilledBytes);
+	}
+}
 
-		FTransform InterpedTransform;
-		InterpedTransform.SetLocation(FMath::Lerp(CurrentTransform.GetLocation(), TargetTransform.GetLocation(), DeltaTime));
-		InterpedTransform.SetRotation(FQuat::Slerp(CurrentTransform.GetRotation(), TargetTransform.GetRotation(), DeltaTime));
-		InterpedTransform.SetScale3D(FMath::Lerp(CurrentTransform.GetScale3D(), TargetTransform.GetScale3D(), DeltaTime));
+void URewindSubsystem::Deinitialize()
+{
+	SpillTimeline.Close();
 
-		Result.LocalTransforms.Add(InterpedTransform);
-		Result.BoneNames.Add(Current.BoneNames[i]);
+	if (PendingTimelineSave.IsValid())
+	{
+		PendingTimelineSave.Wait();
 	}
 
-	Result.SkeletalMeshName = Current.SkeletalMeshName; 
-	Result.SnapshotName = NAME_None; 
-	Result.bIsValid = true;
-
-	return Result;
+	Super::Deinitialize();
 }
 
-void URewindSubsystem::HandleForwardRecording(float DeltaTime,FActorFrameSnapshot& Snapshot)
+void URewindSubsystem::AddReferencedObjects(UObject* InThis, FReferenceCollector& Collector)
 {
-	TRACE_CPUPROFILER_EVENT_SCOPE(URewindSubsystem_Recording);
-	
-	auto RecordedTimeSeconds{GetDefault<URewindDeveloperSettings>()->GetRecordedTimeSeconds()};
-	
-	  for (auto& Actor : ReverseActors)
-    {
-        if (!Actor.IsValid()) continue;
-
-        auto& Data = ActorsData.FindOrAdd(Actor.InActor);
-        Data.RunningTime = 0.f;
-        Data.LeftRunningTime = 0.f;
-        Data.RightRunningTime = 0.f;
-
-        // ----- STEP 2.1: Capture snapshot -----
-        if (Cast<UPrimitiveComponent>(Actor.InActor->GetRootComponent()) && !Actor.InActor->IsA<ACharacter>())
-        {
-            auto* MeshRoot = Cast<UPrimitiveComponent>(Actor.InActor->GetRootComponent());
-            Snapshot = {
-                Actor.InActor->GetActorLocation(),
-                Actor.InActor->GetActorRotation(),
-                MeshRoot->GetPhysicsLinearVelocity(),
-                MeshRoot->GetPhysicsAngularVelocityInRadians(),
-                DeltaTime
-            };
-        }
-        else
-        {
-           auto* Character = Cast<ACharacter>(Actor.InActor.Get());
-           	
-               FPoseSnapshot PoseSnapshot{};
-           	
-               Character->GetMesh()->SnapshotPose(PoseSnapshot);
-   
-               Snapshot = {
-                   Actor.InActor->GetActorLocation(),
-                   Actor.InActor->GetActorRotation(),
-                   Character->GetCapsuleComponent()->GetPhysicsLinearVelocity(),
-                   Character->GetCapsuleComponent()->GetPhysicsAngularVelocityInRadians(),
-                   DeltaTime
-               };
-               Snapshot.PoseSnapshot = PoseSnapshot; 
-        }
-
-        // ----- STEP 2.2: Store snapshot -----
-        if (Data.RecordedTime < RecordedTimeSeconds)
-        {
-            Data.StoredFrames.AddTail(Snapshot);
-            Data.RecordedTime += DeltaTime;
-            Data.bOutOfData = false;
-        }
-        else
-        {
-            while (Data.RecordedTime >= RecordedTimeSeconds)
-            {
-                auto& Frames = Data.StoredFrames;
-                if (!Frames.GetHead()) break;
-
-                float HeadDT = Frames.GetHead()->GetValue().DeltaTime;
-                Frames.RemoveNode(Frames.GetHead());
-                Data.RecordedTime -= HeadDT;
-            }
-
-            Data.StoredFrames.AddTail(Snapshot);
-            Data.RecordedTime += DeltaTime;
-            Data.bOutOfData = false;
-        }
-    }
+	CastChecked<URewindSubsystem>(InThis)->Registry.AddReferencedObjects(Collector);
+	Super::AddReferencedObjects(InThis, Collector);
 }
 
-void URewindSubsystem::HandleReversePlayback(float DeltaTime)
+void URewindSubsystem::ApplySnapshot(int32 Slot, const FRewindedActorFrameSnapshot& Snapshot)
 {
-	
-	TRACE_CPUPROFILER_EVENT_SCOPE(URewindSubsystem_Rewind);
+	SCOPE_CYCLE_COUNTER(STAT_RewindApply);
 
-	/*if (bIsExecutingThreadTask)
-	{
-		return;
-	}*/
-	
-	auto RewindSpeed{GetDefault<URewindDeveloperSettings>()->GetRewindSpeed()};
+	USceneComponent* Root = Registry.Actors[Slot]->GetRootComponent();
+	if (!Root) return;
 
-	int32 ValidActorCount{};
-	float AvgFramesRemaining{};
+	const FQuat Rotation{Snapshot.Rotation.Quaternion()};
+	if (!Root->GetComponentLocation().Equals(Snapshot.Location, UE_KINDA_SMALL_NUMBER) || !Root->GetComponentQuat().Equals(Rotation, UE_KINDA_SMALL_NUMBER))
+	{
+		// One teleporting move for location and rotation, overlaps and attached components are updated once when the scope ends.
+		FScopedMovementUpdate ScopedMovement{Root, EScopedUpdate::DeferredUpdates};
+		Root->SetWorldLocationAndRotation(Snapshot.Location, Rotation, false, nullptr, ETeleportType::TeleportPhysics);
+	}
 
-	
-	 for (auto& Actor : ReverseActors)
-	 {
-	 	if (!Actor.IsValid()) continue;
+	// The recorded velocities are written even when the actor is already in place, its live ones may differ.
+	UPrimitiveComponent* RootPrimitive = Registry.RootPrimitives[Slot];
+	if (!IsValid(RootPrimitive) || !RootPrimitive->IsSimulatingPhysics()) return;
 
-	 	auto* Data = ActorsData.Find(Actor.InActor);
+	if (FBodyInstance* Body = RootPrimitive->GetBodyInstance())
+	{
+		FPhysicsCommand::ExecuteWrite(Body->ActorHandle, [&Snapshot](const FPhysicsActorHandle& Actor)
+		{
+			FPhysicsInterface::SetLinearVelocity_AssumesLocked(Actor, Snapshot.LinearVelocity);
+			FPhysicsInterface::SetAngularVelocity_AssumesLocked(Actor, Snapshot.AngularVelocity);
+		});
+	}
+}
 
-	 	const bool IsCharacter = Actor.InActor->IsA<ACharacter>();
-	 	
-	 	if (!Data || Data->StoredFrames.IsEmpty() || Data->bOutOfData) continue;
+bool URewindSubsystem::SampleBodies(int32 Slot, double Time)
+{
+	const auto& Bodies = Registry.BodyHistories[Slot];
+	if (!Registry.BodyMeshes[Slot] || Bodies.GetNumBodies() == 0) return false;
 
-	 	int32 TotalFrames = 0;
+	auto& States = Registry.BodyStates[Slot];
+	States.SetNumUninitialized(Bodies.GetNumBodies(), EAllowShrinking::No);
+	return Bodies.Sample(Time, States);
+}
 
-	 	if (!Data->StoredFrames.IsEmpty() && !Data->bOutOfData)
-	 	{
-	 		TotalFrames += Data->StoredFrames.Num();
-	 		++ValidActorCount;
-	 	}
+void URewindSubsystem::ApplyBodies(int32 Slot)
+{
+	SCOPE_CYCLE_COUNTER(STAT_RewindApplyBodies);
 
-	 	AvgFramesRemaining = ValidActorCount > 0 ? static_cast<float>(TotalFrames) / ValidActorCount : 0.f;
+	USkeletalMeshComponent* Mesh = Registry.BodyMeshes[Slot];
+	const auto& States = Registry.BodyStates[Slot];
+	if (!IsValid(Mesh) || States.Num() != Mesh->Bodies.Num()) return;
 
-	 	// ----- STEP 3.1: Locate snapshot pair -----
-	 	auto IsCurveSet=RewindConfig.IsCurveSet();
-	 	Data->RunningTime += DeltaTime * (IsCurveSet?RewindConfig.RewindCurve->GetFloatValue(Data->RunningTime):RewindSpeed);
+	// Every body of the mesh in one write lock. Kinematic bodies follow the animation and are left alone.
+	FPhysicsCommand::ExecuteWrite(Mesh, [Mesh, &States]()
+	{
+		for (int32 Index = 0; Index < States.Num(); ++Index)
+		{
+			const FBodyInstance* Body = Mesh->Bodies[Index];
+			if (!Body || !FPhysicsInterface::IsValid(Body->ActorHandle) || !Body->IsInstanceSimulatingPhysics()) continue;
 
-	 	auto Right = Data->StoredFrames.GetTail();
-	 	auto Left = Right->GetPrevNode();
-	 	Data->LeftRunningTime = Data->RightRunningTime + Right->GetValue().DeltaTime;
+			const auto& State = States[Index];
+			FPhysicsInterface::SetGlobalPose_AssumesLocked(Body->ActorHandle, FTransform{State.Rotation, State.Location});
+			FPhysicsInterface::SetLinearVelocity_AssumesLocked(Body->ActorHandle, State.LinearVelocity);
+			FPhysicsInterface::SetAngularVelocity_AssumesLocked(Body->ActorHandle, State.AngularVelocity);
+		}
+	});
+}
 
-	 	while (Data->RunningTime > Data->LeftRunningTime)
-	 	{
+void URewindSubsystem::InterpTargetPose(URewindComponent& InComponent, const FActorData& Data, int32 RightIndex,
+	int32 LeftIndex, float Fraction, FRewindScratch& Scratch) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_RewindInterpolatePose);
 
-	 		Data->RightRunningTime += Right->GetValue().DeltaTime;
-	 		Right = Left;
-	 		Data->LeftRunningTime += Left->GetValue().DeltaTime;
-	 		Left = Left->GetPrevNode();
+	auto& TargetPose = InComponent.GetBackPose();
+	auto& TargetPoseLayoutId = InComponent.GetBackPoseLayoutId();
+	const int32 LayoutId = Data.GetFramePoseLayoutId(RightIndex);
 
-	 		auto Tail = Data->StoredFrames.GetTail();
-	 		Data->RecordedTime -= Tail->GetValue().DeltaTime;
-	 		Data->StoredFrames.RemoveNode(Tail);
+	if (LayoutId == INDEX_NONE || LayoutId != Data.GetFramePoseLayoutId(LeftIndex))
+	{
+		TargetPose.bIsValid = false;
+		return;
+	}
 
-	 		if (Left == Data->StoredFrames.GetHead())
-	 		{
-	 			Data->bOutOfData = true;
-	 		}
-	 	}
+	if (TargetPoseLayoutId != LayoutId)
+	{
+		const auto& Layout = BoneLayouts[LayoutId];
+		TargetPose.BoneNames = Layout.BoneNames;
+		TargetPose.SkeletalMeshName = Layout.SkeletalMeshName;
+		TargetPose.LocalTransforms.SetNum(Layout.Num());
+		TargetPoseLayoutId = LayoutId;
+	}
 
-	 	// ----- STEP 3.2: Interpolate and apply snapshot -----
-	 	if (Data->RunningTime <= Data->LeftRunningTime && Data->RunningTime >= Data->RightRunningTime)
-	 	{
-	 		TRACE_CPUPROFILER_EVENT_SCOPE(URewindSubsystem_CalculateInterp);
+	InterpPoseTransforms(Data.GetPose(RightIndex, Scratch.Poses[0]), Data.GetPose(LeftIndex, Scratch.Poses[1]), Fraction, TargetPose.LocalTransforms);
+	TargetPose.bIsValid = true;
+}
 
-        	
-        	
-	 		const float DeltaTimeAdjusted = Data->RunningTime - Data->RightRunningTime;
-	 		const float Interval = Data->LeftRunningTime - Data->RightRunningTime;
-	 		const float Fraction = DeltaTimeAdjusted / Interval;
+void URewindSubsystem::InterpPoseTransforms(TConstArrayView<FTransform> Current, TConstArrayView<FTransform> Target,
+	float Alpha, TArrayView<FTransform> Out)
+{
+	RewindPoseBlend::BlendPoses(Current, Target, Alpha, Out);
+}
 
-	 		//bIsExecutingThreadTask=true;
+int32 URewindSubsystem::FindOrAddBoneLayout(const USkeletalMesh* InSkeletalMesh)
+{
+	if (!InSkeletalMesh) return INDEX_NONE;
 
-	 		FRewindedActorFrameSnapshot RewindedActorFrameSnapshot{};
+	if (const int32* LayoutId = BoneLayoutIds.Find(InSkeletalMesh))
+	{
+		return *LayoutId;
+	}
 
-	 		RewindedActorFrameSnapshot.Location = FMath::Lerp(
-			   Right->GetValue().Location, Left->GetValue().Location, Fraction);
+	const FReferenceSkeleton& RefSkeleton = InSkeletalMesh->GetRefSkeleton();
+	const int32 NumBones = RefSkeleton.GetNum();
 
-	 		RewindedActorFrameSnapshot.Rotation = FMath::Lerp(
-				 Right->GetValue().Rotation, Left->GetValue().Rotation, Fraction);
+	FRewindBoneLayout& Layout = BoneLayouts.AddDefaulted_GetRef();
+	Layout.SkeletalMeshName = InSkeletalMesh->GetFName();
+	Layout.BoneNames.Reserve(NumBones);
+	Layout.ParentIndices.Reserve(NumBones);
+	for (int32 BoneIndex = 0; BoneIndex < NumBones; ++BoneIndex)
+	{
+		Layout.BoneNames.Add(RefSkeleton.GetBoneName(BoneIndex));
+		Layout.ParentIndices.Add(RefSkeleton.GetParentIndex(BoneIndex));
+	}
 
-	 		RewindedActorFrameSnapshot.LinearVelocity = FMath::Lerp(
-				 Right->GetValue().LinearVelocity, Left->GetValue().LinearVelocity, Fraction);
+	return BoneLayoutIds.Add(InSkeletalMesh, BoneLayouts.Num() - 1);
+}
 
-	 		RewindedActorFrameSnapshot.AngularVelocity = FMath::Lerp(
-				 Right->GetValue().AngularVelocity, Left->GetValue().AngularVelocity, Fraction);
+void URewindSubsystem::UpdatePoseLayout(FActorData& Data, const USkeletalMeshComponent* InMesh)
+{
+	const USkeletalMesh* SkeletalMesh = InMesh ? InMesh->GetSkeletalMeshAsset() : nullptr;
 
-	 		RewindedActorFrameSnapshot.PoseSnapshot = InterpPoseSnapshotTo(Right->GetValue().PoseSnapshot,Left->GetValue().PoseSnapshot,Fraction, 1.f);
-	 		
-	 		if (IsCharacter)
-	 		{
-	 			Actor.InRewindComponent->TargetPose = RewindedActorFrameSnapshot.PoseSnapshot;
-	 		}
+	if (Data.PoseMesh != TObjectKey<USkeletalMesh>(SkeletalMesh))
+	{
+		Data.PoseMesh = SkeletalMesh;
+		Data.PoseLayoutId = FindOrAddBoneLayout(SkeletalMesh);
+	}
 
-	 		SetSnapshotVariables(
-				 Actor.InActor.Get(), RewindedActorFrameSnapshot.Location,  RewindedActorFrameSnapshot.Rotation, RewindedActorFrameSnapshot.LinearVelocity, RewindedActorFrameSnapshot.AngularVelocity);
+	// A different bone count invalidates the recorded poses, so the history starts over.
+	Data.SetPoseBoneCount(BoneLayouts.IsValidIndex(Data.PoseLayoutId) ? BoneLayouts[Data.PoseLayoutId].Num() : 0);
+}
 
+bool URewindSubsystem::CapturePose(const FRewindBoneLayout& Layout, const USkeletalMeshComponent* InMesh,
+	TArrayView<FTransform> OutPose)
+{
+	SCOPE_CYCLE_COUNTER(STAT_RewindCapturePose);
 
-	 		
-	 		/*AsyncTask(ENamedThreads::Type::AnyHiPriThreadNormalTask, [this, Right, Left, Fraction, Actor,IsCharacter]()
-			 {
+	const TArray<FTransform>& ComponentSpaceTransforms = InMesh->GetComponentSpaceTransforms();
+	if (ComponentSpaceTransforms.Num() != Layout.Num() || OutPose.Num() != Layout.Num())
+	{
+		return false;
+	}
 
-				 AsyncTask(ENamedThreads::Type::GameThread, [this,IsCharacter, Right, Left, Fraction, Actor, InterpSnapshot, InterpLocation, InterpRotation, InterpLinearVelocity, InterpAngularVelocity]()
-				 {
-				 	bIsExecutingThreadTask=false;
-					
-				 });
-		 });*/
-	 		
-		 }
-	 }
-	//if the avrg frames remaining of all actors pass the MinAvgThreshold, end the rewind
-	if (AvgFramesRemaining < RewindConfig.MinAvgThreshold)
+	// Same conversion SnapshotPose does, minus the per-frame name and array copies.
+	OutPose[0] = ComponentSpaceTransforms[0];
+	for (int32 BoneIndex = 1; BoneIndex < Layout.Num(); ++BoneIndex)
 	{
-		EndReverse();
+		const int32 ParentIndex = Layout.ParentIndices[BoneIndex];
+		OutPose[BoneIndex] = ComponentSpaceTransforms[BoneIndex].GetRelativeTransform(ComponentSpaceTransforms[ParentIndex]);
 	}
+	return true;
 }
 
-void URewindSubsystem::CalculateSnapshot(FRewindedActorFrameSnapshot& SnapshotOut, bool bIsCharacter)
+void URewindSubsystem::HandleForwardRecording(float DeltaTime)
 {
-	
-	
-	
-}
+	TRACE_CPUPROFILER_EVENT_SCOPE(URewindSubsystem_Recording);
 
+	auto Settings{GetDefault<URewindDeveloperSettings>()};
+	auto RecordedTimeSeconds{Settings->GetRecordedTimeSeconds()};
+	auto ExpectedRate{RewindConfig.SampleRate > 0.f ? FMath::Min(RewindConfig.SampleRate, Settings->GetExpectedTickRate()) : Settings->GetExpectedTickRate()};
+	auto ExpectedFrames{FMath::CeilToInt32(RecordedTimeSeconds * ExpectedRate) + 1};
 
+	RecordingClock += DeltaTime;
 
-void URewindSubsystem::RemovePendingKillActorsOrRequested()
-{
-	
-	for (auto& Data : ReverseActors)
+	// ----- STEP 2.0: Pick each actor's recording LOD -----
+	const bool bUseRecordingLOD{Settings->IsRecordingLODEnabled()};
+	if (bUseRecordingLOD)
 	{
-		if (!Data.InActor.IsValid())
+		SignificanceAccumulator += DeltaTime;
+		if (SignificanceAccumulator >= Settings->GetSignificanceInterval())
 		{
-			PendingRemoveActors.Add(Data.InActor);
+			SignificanceAccumulator = 0.f;
+			UpdateSignificance();
 		}
 	}
-	
-	for (TWeakObjectPtr<AActor>& Actor : PendingRemoveActors)
+	const float LODSampleRates[]{0.f, Settings->GetReducedSampleRate(), Settings->GetMinimalSampleRate()};
+
+	// ----- STEP 2.1: Pick the actors due and prepare their histories on the game thread -----
+	RecordSlots.Reset();
+	for (int32 Slot = 0; Slot < Registry.Num(); ++Slot)
 	{
-		if (!Actor.IsValid()) continue;
-		
-		auto Temp=FRewindActor(Actor.Get(), nullptr);// Assuming null component is fine
-		
-		ReverseActors.Remove(Temp);
-		
-		ActorsData.Remove(Actor.Get());
+		// Actors rewinding with a group aren't recorded until it ends.
+		if (Registry.GroupRewinding[Slot]) continue;
+
+		if (!bUseRecordingLOD)
+		{
+			Registry.RecordingLODs[Slot] = ERewindRecordingLOD::Full;
+		}
+
+		// Actors recorded at a lower rate skip steps until their next frame is due, it then covers the skipped time.
+		Registry.SampleAccumulators[Slot] += DeltaTime;
+		const float SampleRate{LODSampleRates[static_cast<int32>(Registry.RecordingLODs[Slot])]};
+		if (SampleRate > 0.f && Registry.SampleAccumulators[Slot] * SampleRate < 1.f) continue;
+		RecordSlots.Add(Slot);
 	}
 
-	
-	if (PendingRemoveActors.Num()>0)
+	// Actors left out by the budget wait the same way, their next frame covering every tick they waited.
+	const float RecordingBudget{Settings->GetRecordingBudgetMicroseconds()};
+	if (RecordingBudget > 0.f)
 	{
-		UE_LOGFMT(LogRewind,Warning,"Request Removed or Pending Kill Removed Count: {Num}",PendingRemoveActors.Num());
+		FitRecordingBudget(RecordingBudget);
+	}
+	else
+	{
+		SET_DWORD_STAT(STAT_RewindActorsDeferred, 0);
 	}
-	
-	PendingRemoveActors.Reset();
-}
 
+	// Anything that can reset a history or grow the layout table stays on the game thread.
+	for (const int32 Slot : RecordSlots)
+	{
+		Registry.RefreshComponents(Slot);
 
-void URewindSubsystem::StartReverse()
+		auto& Data = Registry.Histories[Slot];
+		const auto* Component = Registry.Components[Slot];
+		Data.SetCompression(Component->FrameCompression, Component->MaxQuantizationError);
+		if (Registry.Kinds[Slot] == ERewindActorKind::Character)
+		{
+			UpdatePoseLayout(Data, Registry.Meshes[Slot]);
+		}
+		Data.ReserveFrames(ExpectedFrames);
+		if (const USkeletalMeshComponent* BodyMesh = Registry.BodyMeshes[Slot])
+		{
+			Registry.BodyHistories[Slot].SetNumBodies(BodyMesh->Bodies.Num());
+			Registry.BodyHistories[Slot].Reserve(ExpectedFrames);
+		}
+	}
+
+	// ----- STEP 2.2: Capture and store, in parallel if enabled -----
+	// Spilled histories are trimmed when their chunks go to disk instead.
+	const int32 NumRecorded{RecordSlots.Num()};
+	const float MemoryWindow{Settings->IsHistorySpillEnabled() ? MAX_flt : RecordedTimeSeconds};
+	const float MinimalWindow{bUseRecordingLOD ? Settings->GetMinimalRecordTime() : MAX_flt};
+	const uint64 RecordStartCycles{FPlatformTime::Cycles64()};
+	if (RewindConfig.bUseParallelRecording && NumRecorded > 1)
+	{
+		constexpr int32 MinBatchSize{32};
+		ParallelForWithExistingTaskContext(GetWorkerScratch(NumRecorded, MinBatchSize), NumRecorded, MinBatchSize, [this, MemoryWindow, MinimalWindow, RecordedTimeSeconds](FRewindScratch& Scratch, int32 Index)
+		{
+			RecordSnapshot(RecordSlots[Index], MemoryWindow, MinimalWindow, Scratch);
+			RecordBodies(RecordSlots[Index], RecordedTimeSeconds);
+		});
+	}
+	else
+	{
+		for (const int32 Slot : RecordSlots)
+		{
+			RecordSnapshot(Slot, MemoryWindow, MinimalWindow, GameThreadScratch);
+			RecordBodies(Slot, RecordedTimeSeconds);
+		}
+	}
+	INC_DWORD_STAT_BY(STAT_RewindFramesRecorded, NumRecorded);
+
+	// Wall time, so parallel recording fits more actors in the same budget.
+	if (NumRecorded > 0)
+	{
+		const double Microseconds{FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - RecordStartCycles) * 1000000.0};
+		RecordCostPerActor = FMath::Lerp(RecordCostPerActor, static_cast<float>(Microseconds / NumRecorded), 0.1f);
+	}
+
+	// Volume rewinds find the actors by where they were last recorded.
+	Registry.SetGridCellSize(Settings->GetActorGridCellSize());
+	for (const int32 Slot : RecordSlots)
+	{
+		Registry.UpdateGridLocation(Slot, Registry.Actors[Slot]->GetActorLocation());
+	}
+
+	// ----- STEP 2.3: Index the new frames for history queries -----
+	if (Settings->IsHistoryIndexEnabled())
+	{
+		IndexRecordedBounds(RecordedTimeSeconds);
+	}
+
+	// ----- STEP 2.4: Move old history to disk -----
+	SpillHistories(RecordedTimeSeconds);
+
+	// ----- STEP 2.5: Stay within the memory budget -----
+	EnforceMemoryBudget(DeltaTime);
+}
+
+void URewindSubsystem::IndexRecordedBounds(float RecordedTimeSeconds)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(URewindSubsystem_IndexRecordedBounds);
+	SCOPE_CYCLE_COUNTER(STAT_RewindHistoryIndex);
+
+	// Spilled histories keep up to a chunk more than the recorded time in memory.
+	const auto* Settings{GetDefault<URewindDeveloperSettings>()};
+	const float Window{RecordedTimeSeconds + (Settings->IsHistorySpillEnabled() ? Settings->GetSpillChunkTime() : 0.f)};
+	HistoryIndex.Configure(Settings->GetHistoryIndexBucketTime(), Settings->GetHistoryIndexCellSize(), Window);
+
+	// Keyframe reduction may have folded the previous tail into the new frame, which the swept bounds still cover.
+	for (const int32 Slot : RecordSlots)
+	{
+		const auto& Data = Registry.Histories[Slot];
+		if (!Data.HasFrames()) continue;
+
+		const auto& Frame = Data.GetFrame(Data.NumFrames() - 1, GameThreadScratch.Frames[0]);
+		const FBox Bounds{Registry.Shapes[Slot].GetWorldBounds(FTransform{Frame.Rotation, Frame.Location})};
+		HistoryIndex.AddFrame(Registry.Actors[Slot], Frame.Timestamp, Bounds, Registry.IndexCursors[Slot]);
+	}
+}
+
+void URewindSubsystem::FitRecordingBudget(float BudgetMicroseconds)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(URewindSubsystem_FitRecordingBudget);
+
+	BudgetedSlots.Reset();
+	for (const int32 Slot : RecordSlots)
+	{
+		if (Registry.Components[Slot]->bAlwaysFullFidelity)
+		{
+			BudgetedSlots.Add(Slot);
+		}
+	}
+
+	const int32 NumPriority{BudgetedSlots.Num()};
+	const int32 NumOthers{RecordSlots.Num() - NumPriority};
+	const float CostPerActor{FMath::Max(RecordCostPerActor, UE_KINDA_SMALL_NUMBER)};
+	const int32 MaxOthers{FMath::Max(FMath::FloorToInt32((BudgetMicroseconds - NumPriority * CostPerActor) / CostPerActor), 1)};
+	SET_DWORD_STAT(STAT_RewindActorsDeferred, FMath::Max(NumOthers - MaxOthers, 0));
+	if (NumOthers <= MaxOthers) return;
+
+	// RecordSlots is in slot order, so starting at the cursor and wrapping around visits the longest waiting actors first.
+	const int32 Start{static_cast<int32>(Algo::LowerBound(RecordSlots, RecordCursor)) % RecordSlots.Num()};
+	int32 NumTaken{0};
+	for (int32 Offset = 0; Offset < RecordSlots.Num() && NumTaken < MaxOthers; ++Offset)
+	{
+		const int32 Slot{RecordSlots[(Start + Offset) % RecordSlots.Num()]};
+		if (Registry.Components[Slot]->bAlwaysFullFidelity) continue;
+
+		BudgetedSlots.Add(Slot);
+		RecordCursor = Slot + 1;
+		++NumTaken;
+	}
+
+	Swap(RecordSlots, BudgetedSlots);
+}
+
+void URewindSubsystem::UpdateSignificance()
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(URewindSubsystem_UpdateSignificance);
+
+	const auto* Settings{GetDefault<URewindDeveloperSettings>()};
+	const UWorld* World{GetWorld()};
+
+	// Every player counts, so a server keeps full fidelity around each client's view as well.
+	ViewLocations.Reset();
+	for (auto Iterator = World->GetPlayerControllerIterator(); Iterator; ++Iterator)
+	{
+		if (const APlayerController* PlayerController{Iterator->Get()})
+		{
+			FVector Location;
+			FRotator Rotation;
+			PlayerController->GetPlayerViewPoint(Location, Rotation);
+			ViewLocations.Add(Location);
+		}
+	}
+
+	const double FullDistanceSquared{FMath::Square(static_cast<double>(Settings->GetFullFidelityDistance()))};
+	const double ReducedDistanceSquared{FMath::Square(static_cast<double>(Settings->GetReducedFidelityDistance()))};
+	// Nothing is rendered on a dedicated server, so only distance counts there.
+	const bool bUseVisibility{World->GetNetMode() != NM_DedicatedServer};
+	const float RenderedWithin{Settings->GetSignificanceInterval() * 2.f};
+
+	for (int32 Slot = 0; Slot < Registry.Num(); ++Slot)
+	{
+		const auto* Component = Registry.Components[Slot];
+		const AActor* Actor = Registry.Actors[Slot];
+		if (Component->bAlwaysFullFidelity || ViewLocations.IsEmpty())
+		{
+			Registry.RecordingLODs[Slot] = ERewindRecordingLOD::Full;
+			continue;
+		}
+
+		const FVector Location{Actor->GetActorLocation()};
+		double DistanceSquared{MAX_dbl};
+		for (const FVector& ViewLocation : ViewLocations)
+		{
+			DistanceSquared = FMath::Min(DistanceSquared, FVector::DistSquared(Location, ViewLocation));
+		}
+
+		const double Scale{FMath::Square(static_cast<double>(Component->SignificanceDistanceScale))};
+		int32 LOD{DistanceSquared <= FullDistanceSquared * Scale ? 0 : DistanceSquared <= ReducedDistanceSquared * Scale ? 1 : 2};
+		if (bUseVisibility && !Actor->WasRecentlyRendered(RenderedWithin))
+		{
+			LOD = FMath::Min(LOD + 1, 2);
+		}
+		Registry.RecordingLODs[Slot] = static_cast<ERewindRecordingLOD>(LOD);
+	}
+}
+
+void URewindSubsystem::RecordSnapshot(int32 Slot, float RecordedTimeSeconds, float MinimalRecordedTimeSeconds, FRewindScratch& Scratch)
+{
+	auto& Data = Registry.Histories[Slot];
+	const float DeltaTime{Registry.SampleAccumulators[Slot]};
+	Registry.SampleAccumulators[Slot] = 0.f;
+
+	// ----- Capture snapshot -----
+	FActorFrameSnapshot Snapshot;
+	const bool bHasPose{CaptureSnapshot(Slot, DeltaTime, Scratch, Snapshot)};
+
+	// ----- Trim history and store snapshot, encoding it if the actor records compressed -----
+	float MaxRecordedTime{FMath::Min(RecordedTimeSeconds, Registry.RecordedTimeLimits[Slot])};
+	if (Registry.RecordingLODs[Slot] == ERewindRecordingLOD::Minimal)
+	{
+		MaxRecordedTime = FMath::Min(MaxRecordedTime, MinimalRecordedTimeSeconds);
+	}
+	Data.RecordFrame(Snapshot, bHasPose ? TConstArrayView<FTransform>(Scratch.CapturedPose) : TConstArrayView<FTransform>(),
+		MaxRecordedTime, Registry.Components[Slot]->KeyframeReduction, Scratch);
+
+	Registry.OutOfData[Slot] = false;
+}
+
+void URewindSubsystem::RecordBodies(int32 Slot, float RecordedTimeSeconds)
+{
+	const USkeletalMeshComponent* Mesh = Registry.BodyMeshes[Slot];
+	// Minimal fidelity is root motion only, bodies included.
+	if (!Mesh || Registry.RecordingLODs[Slot] == ERewindRecordingLOD::Minimal) return;
+
+	SCOPE_CYCLE_COUNTER(STAT_RewindCaptureBodies);
+
+	// Bodies never spill, so they keep the in-memory window whatever the main history does.
+	auto& Bodies = Registry.BodyHistories[Slot];
+	if (Bodies.GetNumBodies() != Mesh->Bodies.Num() || Bodies.GetNumBodies() == 0) return;
+	const TArrayView<FRewindBodyState> States{Bodies.AddFrame(RecordingClock, FMath::Min(RecordedTimeSeconds, Registry.RecordedTimeLimits[Slot]))};
+
+	// One read lock for every body of the mesh rather than one per body.
+	FPhysicsCommand::ExecuteRead(Mesh, [Mesh, States]()
+	{
+		for (int32 Index = 0; Index < States.Num(); ++Index)
+		{
+			const FBodyInstance* Body = Mesh->Bodies[Index];
+			auto& State = States[Index];
+			if (!Body || !FPhysicsInterface::IsValid(Body->ActorHandle))
+			{
+				State = FRewindBodyState();
+				continue;
+			}
+
+			const FTransform Pose{FPhysicsInterface::GetGlobalPose_AssumesLocked(Body->ActorHandle)};
+			State.Location = Pose.GetLocation();
+			State.Rotation = Pose.GetRotation();
+			State.LinearVelocity = FPhysicsInterface::GetLinearVelocity_AssumesLocked(Body->ActorHandle);
+			State.AngularVelocity = FPhysicsInterface::GetAngularVelocity_AssumesLocked(Body->ActorHandle);
+		}
+	});
+}
+
+bool URewindSubsystem::CaptureSnapshot(int32 Slot, float DeltaTime, FRewindScratch& Scratch, FActorFrameSnapshot& OutSnapshot) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_RewindCapture);
+
+	const auto& Data = Registry.Histories[Slot];
+	const AActor* Actor = Registry.Actors[Slot];
+
+	auto& Snapshot = OutSnapshot;
+	Snapshot = FActorFrameSnapshot{
+		Actor->GetActorLocation(),
+		Actor->GetActorRotation(),
+		FVector::ZeroVector,
+		FVector::ZeroVector,
+		DeltaTime
+	};
+	Snapshot.Timestamp = RecordingClock;
+	bool bHasPose{false};
+
+	switch (Registry.Kinds[Slot])
+	{
+	case ERewindActorKind::Primitive:
+		{
+			const UPrimitiveComponent* RootPrimitive = Registry.RootPrimitives[Slot];
+			Snapshot.LinearVelocity = RootPrimitive->GetPhysicsLinearVelocity();
+			Snapshot.AngularVelocity = RootPrimitive->GetPhysicsAngularVelocityInRadians();
+			Snapshot.bHasLinearVelocity = RootPrimitive->IsSimulatingPhysics();
+			Snapshot.bHasAngularVelocity = Snapshot.bHasLinearVelocity;
+			break;
+		}
+	case ERewindActorKind::Character:
+		{
+			// The capsule only has a physics velocity while simulating, the movement component's velocity is always valid.
+			const auto* Character = Registry.Characters[Slot];
+			const auto* Capsule = Character->GetCapsuleComponent();
+			Snapshot.LinearVelocity = Capsule->IsSimulatingPhysics() ? Capsule->GetPhysicsLinearVelocity() : Character->GetVelocity();
+			Snapshot.AngularVelocity = Capsule->GetPhysicsAngularVelocityInRadians();
+			Snapshot.bHasLinearVelocity = true;
+			Snapshot.bHasAngularVelocity = Capsule->IsSimulatingPhysics();
+
+			// Only the transforms are stored per frame; names and hierarchy live in the shared layout.
+			if (BoneLayouts.IsValidIndex(Data.PoseLayoutId) && Registry.RecordingLODs[Slot] != ERewindRecordingLOD::Minimal)
+			{
+				const auto& PoseLayout = BoneLayouts[Data.PoseLayoutId];
+				Scratch.CapturedPose.SetNumUninitialized(PoseLayout.Num(), EAllowShrinking::No);
+				bHasPose = CapturePose(PoseLayout, Registry.Meshes[Slot], Scratch.CapturedPose);
+				Snapshot.PoseLayoutId = bHasPose ? Data.PoseLayoutId : INDEX_NONE;
+			}
+			break;
+		}
+	default:
+		break;
+	}
+
+	return bHasPose;
+}
+
+void URewindSubsystem::EnforceMemoryBudget(float DeltaTime)
+{
+	const auto* Settings{GetDefault<URewindDeveloperSettings>()};
+	const int64 Budget{Settings->GetHistoryMemoryBudgetBytes()};
+	if (Budget <= 0) return;
+
+	TRACE_CPUPROFILER_EVENT_SCOPE(URewindSubsystem_EnforceMemoryBudget);
+	SCOPE_CYCLE_COUNTER(STAT_RewindMemoryBudget);
+
+	const float FullWindow{Settings->GetRecordedTimeSeconds()};
+	int64 TotalBytes{GetHistoryMemoryBytes()};
+
+	if (TotalBytes <= Budget)
+	{
+		for (float& Limit : Registry.RecordedTimeLimits)
+		{
+			Limit = Limit < FullWindow ? Limit + DeltaTime : MAX_flt;
+		}
+		return;
+	}
+
+	// ----- Drop whole timeline branches, oldest first -----
+	while (TotalBytes > Budget && !BranchTree.GetBranches().IsEmpty())
+	{
+		const int64 BytesBefore{BranchTree.GetMemoryBytes()};
+		BranchTree.RemoveOldest();
+		TotalBytes -= BytesBefore - BranchTree.GetMemoryBytes();
+	}
+
+	// Bodies follow the head of the actor's history, nothing samples them further back.
+	const auto TrimBodies{[this](int32 Slot)
+	{
+		auto& Bodies = Registry.BodyHistories[Slot];
+		const auto& Data = Registry.Histories[Slot];
+		const int64 BytesBefore{Bodies.GetMemoryBytes()};
+		if (Data.HasFrames())
+		{
+			Bodies.TrimHead(Data.GetFrameTimestamp(0));
+		}
+		return BytesBefore - Bodies.GetMemoryBytes();
+	}};
+
+	// ----- Thin the older half of the histories -----
+	const double ThinBefore{RecordingClock - FullWindow * 0.5};
+	for (int32 Slot = 0; Slot < Registry.Num() && TotalBytes > Budget; ++Slot)
+	{
+		auto& Data = Registry.Histories[Slot];
+		const int64 BytesBefore{Data.GetMemoryBytes()};
+		Data.ThinFrames(ThinBefore, Settings->GetMaxThinnedFrameInterval());
+		TotalBytes -= BytesBefore - Data.GetMemoryBytes();
+	}
+
+	// ----- Halve the windows of low priority actors, lowest priority first -----
+	if (TotalBytes > Budget)
+	{
+		BudgetPriorities.Reset();
+		for (const auto* Component : Registry.Components)
+		{
+			BudgetPriorities.AddUnique(Component->HistoryPriority);
+		}
+		BudgetPriorities.Sort();
+
+		const float MinWindow{FMath::Min(Settings->GetMinShortenedRecordTime(), FullWindow)};
+		for (int32 PriorityIndex = 0; PriorityIndex < BudgetPriorities.Num() - 1 && TotalBytes > Budget; ++PriorityIndex)
+		{
+			bool bShortened{true};
+			while (bShortened && TotalBytes > Budget)
+			{
+				bShortened = false;
+				for (int32 Slot = 0; Slot < Registry.Num(); ++Slot)
+				{
+					auto& Data = Registry.Histories[Slot];
+					float& Limit = Registry.RecordedTimeLimits[Slot];
+					const float Window{FMath::Min(Limit, Data.GetRecordedTime())};
+					if (Registry.Components[Slot]->HistoryPriority != BudgetPriorities[PriorityIndex] || Window <= MinWindow) continue;
+
+					Limit = FMath::Max(Window * 0.5f, MinWindow);
+					const int64 BytesBefore{Data.GetMemoryBytes()};
+					Data.TrimHead(Limit);
+					TotalBytes -= BytesBefore - Data.GetMemoryBytes() + TrimBodies(Slot);
+					DiscardSpilledFrames(Slot);
+					bShortened = true;
+				}
+			}
+		}
+	}
+
+	// ----- Drop the oldest frames across every actor -----
+	if (TotalBytes > Budget)
+	{
+		const auto IsOlder{[](const TPair<double, int32>& A, const TPair<double, int32>& B) { return A.Key < B.Key; }};
+
+		// Every actor keeps the two frames playback needs.
+		BudgetOldestHeads.Reset();
+		for (int32 Slot = 0; Slot < Registry.Num(); ++Slot)
+		{
+			if (Registry.Histories[Slot].NumFrames() > 2)
+			{
+				BudgetOldestHeads.Emplace(Registry.Histories[Slot].GetFrameTimestamp(0), Slot);
+			}
+		}
+		BudgetOldestHeads.Heapify(IsOlder);
+
+		while (TotalBytes > Budget && !BudgetOldestHeads.IsEmpty())
+		{
+			TPair<double, int32> Oldest;
+			BudgetOldestHeads.HeapPop(Oldest, IsOlder, EAllowShrinking::No);
+
+			auto& Data = Registry.Histories[Oldest.Value];
+			const int64 BytesBefore{Data.GetMemoryBytes()};
+			Data.PopHeadFrame();
+			TotalBytes -= BytesBefore - Data.GetMemoryBytes() + TrimBodies(Oldest.Value);
+			DiscardSpilledFrames(Oldest.Value);
+
+			if (Data.NumFrames() > 2)
+			{
+				BudgetOldestHeads.HeapPush({Data.GetFrameTimestamp(0), Oldest.Value}, IsOlder);
+			}
+		}
+	}
+}
+
+void URewindSubsystem::SpillHistories(float RecordedTimeSeconds)
+{
+	const auto* Settings{GetDefault<URewindDeveloperSettings>()};
+	if (!Settings->IsHistorySpillEnabled()) return;
+
+	TRACE_CPUPROFILER_EVENT_SCOPE(URewindSubsystem_Spill);
+	SCOPE_CYCLE_COUNTER(STAT_RewindSpill);
+
+	if (!SpillTimeline.IsOpen())
+	{
+		SpillTimeline.Open(FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("Rewind"), FGuid::NewGuid().ToString()), Settings->GetSpillSegmentBytes());
+	}
+
+	const float ChunkTime{Settings->GetSpillChunkTime()};
+	const float SpillWindow{FMath::Max(Settings->GetSpillRecordTime(), RecordedTimeSeconds)};
+
+	for (int32 Slot = 0; Slot < Registry.Num(); ++Slot)
+	{
+		// A rewinding group maps chunks back into its histories, which must not go straight back out.
+		if (Registry.GroupRewinding[Slot]) continue;
+
+		auto& Data = Registry.Histories[Slot];
+		auto& Spill = Registry.Spills[Slot];
+
+		// Without a timeline the memory window is all there is.
+		if (!SpillTimeline.IsOpen())
+		{
+			Data.TrimHead(RecordedTimeSeconds);
+			continue;
+		}
+
+		while (Data.GetRecordedTime() >= RecordedTimeSeconds + ChunkTime)
+		{
+			// Playback always keeps two frames in memory to interpolate between.
+			int32 NumFrames{0};
+			float ChunkRecordedTime{0.f};
+			while (ChunkRecordedTime < ChunkTime && NumFrames < Data.NumFrames() - 2)
+			{
+				ChunkRecordedTime += Data.GetFrameDeltaTime(NumFrames++);
+			}
+			if (NumFrames == 0) break;
+
+			SpillBuffer.Reset();
+			Data.WriteHeadFrames(NumFrames, SpillBuffer);
+
+			auto& Chunk = Spill.Chunks.AddDefaulted_GetRef();
+			Chunk.NumFrames = NumFrames;
+			Chunk.RecordedTime = ChunkRecordedTime;
+			Chunk.Format = Data.GetFormat();
+			SpillTimeline.Append(SpillBuffer, Chunk);
+
+			for (int32 Index = 0; Index < NumFrames; ++Index)
+			{
+				Data.PopHeadFrame();
+			}
+			Spill.NumFrames += NumFrames;
+			Spill.RecordedTime += ChunkRecordedTime;
+		}
+
+		while (!Spill.IsEmpty() && Spill.RecordedTime - Spill.Chunks[0].RecordedTime + Data.GetRecordedTime() >= SpillWindow)
+		{
+			Spill.NumFrames -= Spill.Chunks[0].NumFrames;
+			Spill.RecordedTime -= Spill.Chunks[0].RecordedTime;
+			SpillTimeline.Release(Spill.Chunks[0]);
+			Spill.Chunks.RemoveAt(0, 1, EAllowShrinking::No);
+		}
+	}
+
+	// Every chunk spilled this tick reaches the file in one write.
+	SpillTimeline.Flush();
+}
+
+void URewindSubsystem::RestoreSpilledHistories()
+{
+	if (!SpillTimeline.IsOpen()) return;
+
+	TRACE_CPUPROFILER_EVENT_SCOPE(URewindSubsystem_RestoreSpilled);
+
+	const float PrefetchTime{GetDefault<URewindDeveloperSettings>()->GetSpillPrefetchTime()};
+
+	for (int32 Slot = 0; Slot < Registry.Num(); ++Slot)
+	{
+		RestoreSpilledHistory(Slot, PrefetchTime);
+	}
+}
+
+void URewindSubsystem::RestoreSpilledHistory(int32 Slot, float PrefetchTime)
+{
+	auto& Spill = Registry.Spills[Slot];
+	if (Spill.IsEmpty()) return;
+
+	auto& Data = Registry.Histories[Slot];
+
+	if (!Spill.Prefetch.IsValid())
+	{
+		// History left in memory ahead of the cursor
+		const float Remaining{Data.GetRecordedTime() - (Registry.PlaybackCursors[Slot].RunningTime - Registry.PlaybackCursors[Slot].RightRunningTime)};
+		if (Remaining < PrefetchTime)
+		{
+			Spill.Prefetch = SpillTimeline.Prefetch(Spill.Chunks.Last());
+		}
+		return;
+	}
+
+	// Never wait on the disk, playback holds the actor on its oldest frame until the chunk is mapped.
+	if (!Spill.Prefetch.IsReady()) return;
+
+	const FRewindSpilledChunk Chunk{Spill.Chunks.Pop(EAllowShrinking::No)};
+	Spill.NumFrames -= Chunk.NumFrames;
+	Spill.RecordedTime -= Chunk.RecordedTime;
+
+	bool bRestored{false};
+	if (const TUniquePtr<FRewindMappedChunk> Mapped{Spill.Prefetch.Consume()})
+	{
+		bRestored = Data.PrependFrames(Chunk.Format, Mapped->GetBytes(), Chunk.NumFrames);
+	}
+	SpillTimeline.Release(Chunk);
+
+	// Recorded in a format the history has since left, or unreadable: nothing older can join it either.
+	if (!bRestored)
+	{
+		DiscardSpilledFrames(Slot);
+	}
+}
+
+void URewindSubsystem::DiscardSpilledFrames(int32 Slot)
+{
+	auto& Spill = Registry.Spills[Slot];
+	if (Spill.IsEmpty()) return;
+
+	for (const auto& Chunk : Spill.Chunks)
+	{
+		SpillTimeline.Release(Chunk);
+	}
+	Spill.Chunks.Reset();
+	Spill.NumFrames = 0;
+	Spill.RecordedTime = 0.f;
+	Spill.Prefetch = TFuture<TUniquePtr<FRewindMappedChunk>>();
+}
+
+void URewindSubsystem::RemoveSlot(int32 Slot)
+{
+	DiscardSpilledFrames(Slot);
+	Registry.RemoveAtSwap(Slot);
+}
+
+TArrayView<FRewindScratch> URewindSubsystem::GetWorkerScratch(int32 NumJobs, int32 MinBatchSize)
+{
+	WorkerScratch.SetNum(FMath::Max(WorkerScratch.Num(), ParallelForImpl::GetNumberOfThreadTasks(NumJobs, MinBatchSize, EParallelForFlags::None)));
+	return WorkerScratch;
+}
+
+void URewindSubsystem::HandleReversePlayback(float DeltaTime)
+{
+
+	TRACE_CPUPROFILER_EVENT_SCOPE(URewindSubsystem_Rewind);
+
+	auto RewindSpeed{GetDefault<URewindDeveloperSettings>()->GetRewindSpeed()};
+
+	// ----- STEP 3.0: Bring spilled history back ahead of the cursor -----
+	if (!bReplaying)
+	{
+		RestoreSpilledHistories();
+	}
+
+	// ----- STEP 3.1: Gather the actors that still have history -----
+	// Going forward, actors that ran out of history going back have their futures ahead.
+	PlaybackJobs.Reset();
+	for (int32 Slot = 0; Slot < Registry.Num(); ++Slot)
+	{
+		if ((Registry.OutOfData[Slot] && !bReplaying) || !Registry.Histories[Slot].HasFrames()) continue;
+
+		PlaybackJobs.AddDefaulted_GetRef().Slot = Slot;
+	}
+
+	const int32 TotalFrames{RunPlaybackJobs(DeltaTime, RewindSpeed, RewindConfig)};
+
+	// A replay ends once every actor is back on its newest frame.
+	if (bReplaying)
+	{
+		if (TotalFrames == 0)
+		{
+			EndReverse();
+		}
+		return;
+	}
+
+	//if the avrg frames remaining of all actors pass the MinAvgThreshold, end the rewind
+	const float AvgFramesRemaining{PlaybackJobs.Num() > 0 ? static_cast<float>(TotalFrames) / PlaybackJobs.Num() : 0.f};
+	if (AvgFramesRemaining < RewindConfig.MinAvgThreshold)
+	{
+		EndReverse();
+	}
+}
+
+int32 URewindSubsystem::RunPlaybackJobs(float DeltaTime, float RewindSpeed, const FRewindConfig& Config)
+{
+	// ----- STEP 3.2: Locate snapshot pairs and interpolate, in parallel if enabled -----
+	if (Config.bUseMultiThreading && PlaybackJobs.Num() > 1)
+	{
+		TRACE_CPUPROFILER_EVENT_SCOPE(URewindSubsystem_CalculateInterp);
+
+		constexpr int32 MinBatchSize{32};
+		ParallelForWithExistingTaskContext(GetWorkerScratch(PlaybackJobs.Num(), MinBatchSize), PlaybackJobs.Num(), MinBatchSize, [this, DeltaTime, RewindSpeed, &Config](FRewindScratch& Scratch, int32 JobIndex)
+		{
+			CalculateSnapshot(PlaybackJobs[JobIndex], DeltaTime, RewindSpeed, Config, Scratch);
+		});
+	}
+	else
+	{
+		TRACE_CPUPROFILER_EVENT_SCOPE(URewindSubsystem_CalculateInterp);
+
+		for (auto& Job : PlaybackJobs)
+		{
+			CalculateSnapshot(Job, DeltaTime, RewindSpeed, Config, GameThreadScratch);
+		}
+	}
+
+	// ----- STEP 3.3: Apply on the game thread -----
+	int32 TotalFrames{};
+	for (const auto& Job : PlaybackJobs)
+	{
+		TotalFrames += Job.FramesRemaining;
+
+		if (Job.bHasResult)
+		{
+			ApplySnapshot(Job.Slot, Job.Result);
+			INC_DWORD_STAT(STAT_RewindFramesInterpolated);
+		}
+		if (Job.bHasBodies)
+		{
+			ApplyBodies(Job.Slot);
+		}
+		// Every pose of this tick is complete, so animation can switch over to them.
+		Registry.Components[Job.Slot]->PublishPose();
+	}
+	return TotalFrames;
+}
+
+void URewindSubsystem::HandleGroupPlayback(int32 GroupIndex, float DeltaTime)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(URewindSubsystem_GroupRewind);
+
+	auto& Group = Groups[GroupIndex];
+
+	// Only the group's own slots are visited, however many actors the rest of the world records.
+	const float PrefetchTime{GetDefault<URewindDeveloperSettings>()->GetSpillPrefetchTime()};
+	PlaybackJobs.Reset();
+	for (int32 Index = Group.Actors.Num() - 1; Index >= 0; --Index)
+	{
+		const int32 Slot{Registry.Find(Group.Actors[Index])};
+		if (Slot == INDEX_NONE)
+		{
+			Group.Actors.RemoveAtSwap(Index, EAllowShrinking::No);
+			continue;
+		}
+
+		if (SpillTimeline.IsOpen())
+		{
+			RestoreSpilledHistory(Slot, PrefetchTime);
+		}
+		if (Registry.OutOfData[Slot] || !Registry.Histories[Slot].HasFrames()) continue;
+
+		PlaybackJobs.AddDefaulted_GetRef().Slot = Slot;
+	}
+
+	// Applying the snapshots may start or end groups, so nothing of this one is read through Groups after it.
+	const FName GroupName{Group.Name};
+	const FRewindConfig Config{Group.Config};
+	const int32 TotalFrames{RunPlaybackJobs(DeltaTime, Config.RewindSpeed, Config)};
+
+	const float AvgFramesRemaining{PlaybackJobs.Num() > 0 ? static_cast<float>(TotalFrames) / PlaybackJobs.Num() : 0.f};
+	if (AvgFramesRemaining < Config.MinAvgThreshold)
+	{
+		EndGroupReverse(GroupName);
+	}
+}
+
+int32 URewindSubsystem::StartVolumeReverse(FName GroupName, const FBox& Volume, const FRewindConfig& Config)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(URewindSubsystem_StartVolumeReverse);
+
+	GroupSlots.Reset();
+	Registry.GatherGridSlots(Volume, GroupSlots);
+
+	// The grid only narrows it down to the cells the volume touches.
+	GroupSlots.RemoveAllSwap([this, &Volume](int32 Slot)
+	{
+		return !Volume.IsInsideOrOn(Registry.Actors[Slot]->GetActorLocation());
+	}, EAllowShrinking::No);
+
+	return StartGroup(GroupName, GroupSlots, Config);
+}
+
+int32 URewindSubsystem::StartGroupReverse(FName GroupName, const TArray<AActor*>& InActors, const FRewindConfig& Config)
+{
+	GroupSlots.Reset();
+	for (AActor* Actor : InActors)
+	{
+		const int32 Slot{Registry.Find(Actor)};
+		if (Slot != INDEX_NONE)
+		{
+			GroupSlots.AddUnique(Slot);
+		}
+	}
+
+	return StartGroup(GroupName, GroupSlots, Config);
+}
+
+void URewindSubsystem::EndGroupReverse(FName GroupName)
+{
+	const int32 GroupIndex{FindGroup(GroupName)};
+	if (GroupIndex != INDEX_NONE)
+	{
+		EndGroup(GroupIndex);
+	}
+}
+
+bool URewindSubsystem::IsGroupReversing(FName GroupName) const
+{
+	return FindGroup(GroupName) != INDEX_NONE;
+}
+
+int32 URewindSubsystem::StartGroup(FName GroupName, TConstArrayView<int32> Slots, const FRewindConfig& Config)
+{
+	if (bRewindingTime || bSeeking || GroupName.IsNone() || FindGroup(GroupName) != INDEX_NONE) return 0;
+
+	FRewindGroup Group;
+	Group.Name = GroupName;
+	Group.Config = Config;
+	for (const int32 Slot : Slots)
+	{
+		if (Registry.GroupRewinding[Slot] || !Registry.Histories[Slot].HasFrames()) continue;
+
+		// The group's clock starts at each actor's newest frame.
+		Registry.PlaybackCursors[Slot] = FRewindPlaybackCursor();
+		Registry.GroupRewinding[Slot] = true;
+		Registry.OutOfData[Slot] = false;
+		Group.Actors.Add(Registry.Actors[Slot]);
+	}
+	if (Group.Actors.IsEmpty()) return 0;
+
+	const int32 NumActors{Group.Actors.Num()};
+	UE_LOGFMT(LogRewind,Verbose,"Started rewinding group {Group} of {Num} actors",GroupName,NumActors);
+
+	TRACE_BOOKMARK(TEXT("URewindSubsystem::StartGroup %s"), *GroupName.ToString())
+
+	FRegistryIterationScope IterationScope{*this};
+
+	// Listeners may start or end groups in turn, so they are told once this one is in place.
+	const TArray<TObjectKey<AActor>> Started{Group.Actors};
+	Groups.Add(MoveTemp(Group));
+	for (const auto& Actor : Started)
+	{
+		const int32 Slot{Registry.Find(Actor)};
+		if (Slot == INDEX_NONE) continue;
+
+		Registry.Components[Slot]->bReversingTime = true;
+		Registry.Components[Slot]->OnStartReverseTime.Broadcast();
+	}
+	return NumActors;
+}
+
+void URewindSubsystem::EndGroup(int32 GroupIndex)
+{
+	const FRewindGroup Group{MoveTemp(Groups[GroupIndex])};
+	Groups.RemoveAt(GroupIndex);
+
+	FRegistryIterationScope IterationScope{*this};
+
+	for (const auto& Actor : Group.Actors)
+	{
+		const int32 Slot{Registry.Find(Actor)};
+		if (Slot == INDEX_NONE) continue;
+
+		// Recording picks up from where playback left the actor, the time it spent rewinding isn't in its history. The
+		// next frame spans that gap, so its DeltaTime still adds up to its Timestamp like every other frame's.
+		const auto& Data = Registry.Histories[Slot];
+		float Gap{0.f};
+		if (Data.HasFrames())
+		{
+			const double TailTimestamp{Data.GetFrameTimestamp(Data.NumFrames() - 1)};
+			Registry.BodyHistories[Slot].TrimTail(TailTimestamp);
+			Gap = static_cast<float>(FMath::Max(RecordingClock - TailTimestamp, 0.0));
+		}
+		Registry.GroupRewinding[Slot] = false;
+		Registry.OutOfData[Slot] = false;
+		Registry.SampleAccumulators[Slot] = Gap;
+		Registry.IndexCursors[Slot] = FRewindIndexCursor();
+		Registry.Spills[Slot].Prefetch = TFuture<TUniquePtr<FRewindMappedChunk>>();
+		Registry.UpdateGridLocation(Slot, Registry.Actors[Slot]->GetActorLocation());
+	}
+
+	UE_LOGFMT(LogRewind,Verbose,"Ended rewinding group {Group}",Group.Name);
+
+	for (const auto& Actor : Group.Actors)
+	{
+		const int32 Slot{Registry.Find(Actor)};
+		if (Slot == INDEX_NONE) continue;
+
+		Registry.Components[Slot]->bReversingTime = false;
+		Registry.Components[Slot]->OnEndReverseTime.Broadcast();
+	}
+}
+
+void URewindSubsystem::EndAllGroups()
+{
+	while (!Groups.IsEmpty())
+	{
+		EndGroup(Groups.Num() - 1);
+	}
+}
+
+int32 URewindSubsystem::FindGroup(FName GroupName) const
+{
+	return Groups.IndexOfByPredicate([GroupName](const FRewindGroup& Group) { return Group.Name == GroupName; });
+}
+
+void URewindSubsystem::CalculateSnapshot(FRewindPlaybackJob& Job, float DeltaTime, float RewindSpeed, const FRewindConfig& Config, FRewindScratch& Scratch)
+{
+	SCOPE_CYCLE_COUNTER(STAT_RewindInterpolate);
+
+	const int32 Slot{Job.Slot};
+	auto& Data = Registry.Histories[Slot];
+	auto& Cursor = Registry.PlaybackCursors[Slot];
+
+	// Spilled frames are still ahead of the cursor, the actor waits on its oldest frame until they are mapped back.
+	const bool bHasSpilledFrames{!Registry.Spills[Slot].IsEmpty()};
+	Job.FramesRemaining = Data.NumFrames() + Registry.Spills[Slot].NumFrames;
+	Job.bHasResult = false;
+	Job.bHasBodies = false;
+
+	const float Step{DeltaTime * (Config.IsCurveSet() ? Config.RewindCurve->GetFloatValue(Cursor.RunningTime) : RewindSpeed)};
+
+	int32 LeftIndex, RightIndex;
+	float Fraction;
+	bool bExhausted;
+	bool bHasPair;
+	if (bReplaying)
+	{
+		auto& Future = Registry.Futures[Slot];
+		bHasPair = Data.StepReplay(Cursor, Step, Future, LeftIndex, RightIndex, Fraction, bExhausted);
+		Job.FramesRemaining = bExhausted ? 0 : Future.NumFrames() + 1;
+		Registry.OutOfData[Slot] = false;
+	}
+	else
+	{
+		// Only a rewind of everything forks the timeline, a group drops the frames it passes.
+		FActorData* Future{Registry.GroupRewinding[Slot] ? nullptr : &Registry.Futures[Slot]};
+		bHasPair = Data.StepPlayback(Cursor, Step, LeftIndex, RightIndex, Fraction, bExhausted, Future);
+		if (bExhausted)
+		{
+			Registry.OutOfData[Slot] = !bHasSpilledFrames;
+		}
+	}
+	if (!bHasPair)
+	{
+		return;
+	}
+
+	Job.Result = InterpolateFrames(Data.GetFrame(RightIndex, Scratch.Frames[0]), Data.GetFrame(LeftIndex, Scratch.Frames[1]), Fraction);
+	Job.bHasResult = true;
+
+	if (Registry.Kinds[Slot] == ERewindActorKind::Character)
+	{
+		InterpTargetPose(*Registry.Components[Slot], Data, RightIndex, LeftIndex, Fraction, Scratch);
+	}
+
+	// Bodies are found by time, so they stay whole for a replay and are only trimmed once recording resumes.
+	if (Registry.BodyMeshes[Slot])
+	{
+		const double RightTimestamp{Data.GetFrameTimestamp(RightIndex)};
+		Job.bHasBodies = SampleBodies(Slot, FMath::Lerp(RightTimestamp, Data.GetFrameTimestamp(LeftIndex), static_cast<double>(Fraction)));
+	}
+}
+
+
+
+void URewindSubsystem::RemovePendingActors()
+{
+	for (const auto& Actor : PendingRemoveActors)
+	{
+		const int32 Slot{Registry.Find(Actor)};
+		if (Slot != INDEX_NONE) RemoveSlot(Slot);
+	}
+
+	if (PendingRemoveActors.Num()>0)
+	{
+		UE_LOGFMT(LogRewind,Verbose,"Removed {Num} actors from rewind",PendingRemoveActors.Num());
+	}
+
+	PendingRemoveActors.Reset();
+}
+
+
+void URewindSubsystem::StartReplay()
+{
+	if (!bRewindingTime) return;
+
+	bReplaying = true;
+}
+
+bool URewindSubsystem::IsReplaying() const
+{
+	return bReplaying;
+}
+
+TArray<int32> URewindSubsystem::GetBranchIds() const
+{
+	TArray<int32> Ids;
+	Ids.Reserve(BranchTree.GetBranches().Num());
+	for (const auto& Branch : BranchTree.GetBranches())
+	{
+		Ids.Add(Branch.Id);
+	}
+	return Ids;
+}
+
+int32 URewindSubsystem::GetCurrentBranchId() const
+{
+	return BranchTree.GetCurrentId();
+}
+
+bool URewindSubsystem::SwitchToBranch(int32 BranchId)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(URewindSubsystem_SwitchToBranch);
+
+	if (bRewindingTime || bSeeking) return false;
+	if (!BranchTree.GetBranches().ContainsByPredicate([BranchId](const FRewindBranch& Branch) { return Branch.Id == BranchId; })) return false;
+
+	EndAllGroups();
+
+	double ForkTimestamp;
+	BranchTree.SwitchTo(BranchId, Registry.GetActorKeys(), Registry.Histories, ForkTimestamp);
+
+	for (int32 Slot = 0; Slot < Registry.Num(); ++Slot)
+	{
+		// Spilled chunks are older than the frames in memory. Unless some of those are from before the fork, the chunks
+		// may hold frames of the timeline left behind.
+		const auto& Data = Registry.Histories[Slot];
+		if (!Data.HasFrames() || Data.GetFrameTimestamp(0) > ForkTimestamp)
+		{
+			DiscardSpilledFrames(Slot);
+		}
+
+		// Bodies aren't branched, the switched to timeline has none past the fork.
+		Registry.BodyHistories[Slot].TrimTail(ForkTimestamp);
+		Registry.OutOfData[Slot] = false;
+		Registry.IndexCursors[Slot] = FRewindIndexCursor();
+	}
+
+	RecordingClock = GetNewestTimestamp();
+	HistoryIndex.DiscardAfter(ForkTimestamp);
+	FMemory::Memzero(Registry.SampleAccumulators.GetData(), Registry.SampleAccumulators.Num() * sizeof(float));
+
+	UE_LOGFMT(LogRewind,Log,"Switched to timeline branch {Branch}, rebuilt after {Time}s",BranchId,ForkTimestamp);
+
+	// Puts every actor on its newest frame of the branch.
+	SeekTo(0.f);
+	EndSeek();
+	return true;
+}
+
+double URewindSubsystem::GetNewestTimestamp() const
 {
+	double NewestTimestamp{-UE_DOUBLE_BIG_NUMBER};
+	for (const auto& Data : Registry.Histories)
+	{
+		if (Data.HasFrames())
+		{
+			NewestTimestamp = FMath::Max(NewestTimestamp, Data.GetFrameTimestamp(Data.NumFrames() - 1));
+		}
+	}
+	return NewestTimestamp > -UE_DOUBLE_BIG_NUMBER ? NewestTimestamp : RecordingClock;
+}
+
+void URewindSubsystem::StartReverse()
+{
+	// Turning a replay back keeps the cursors where they are.
+	if (bRewindingTime)
+	{
+		bReplaying = false;
+		return;
+	}
+
+	EndSeek();
+	EndAllGroups();
+
+	// Close the partial sample so playback starts from where the actors are now.
+	if (RewindConfig.SampleRate > 0.f && SampleAccumulator > 0.f)
+	{
+		HandleForwardRecording(SampleAccumulator);
+		SampleAccumulator = 0.f;
+	}
+
+	// Every playback starts measuring from the newest frame.
+	FMemory::Memzero(Registry.PlaybackCursors.GetData(), Registry.PlaybackCursors.Num() * sizeof(FRewindPlaybackCursor));
+
 	bRewindingTime = true;
 
+	// Chunks are only mapped back from closed segments.
+	SpillTimeline.Seal();
+
+	FRegistryIterationScope IterationScope{*this};
+
 	//OnStartReverse.Broadcast();
-	
+
 	TRACE_BOOKMARK(TEXT("URewindSubsystem::StartReverse"))
-	
-	for (auto& Actor :ReverseActors)
-	{
-		if (!Actor.IsValid()) continue;
 
-		Actor.InRewindComponent->bReversingTime=true;
-		Actor.InRewindComponent->OnStartReverseTime.Broadcast();
+	for (int32 Slot = 0; Slot < Registry.Num(); ++Slot)
+	{
+		Registry.Components[Slot]->bReversingTime=true;
+		Registry.Components[Slot]->OnStartReverseTime.Broadcast();
 	}
-	
+
 }
 
 void URewindSubsystem::EndReverse()
 {
 	bRewindingTime = false;
-	
+	bReplaying = false;
+
+	// Playback took the frames it passed off the histories, so the clock continues from the newest frame left.
+	RecordingClock = GetNewestTimestamp();
+
+	// Recording resumes here, so what playback went back past is another timeline from now on.
+	BranchTree.Fork(RecordingClock, Registry.GetActorKeys(), Registry.Futures, GetDefault<URewindDeveloperSettings>()->GetMaxTimelineBranches());
+	// Each actor's next frame starts from where playback left it, not from its last frame before the rewind.
+	FMemory::Memzero(Registry.SampleAccumulators.GetData(), Registry.SampleAccumulators.Num() * sizeof(float));
+
+	for (auto& Bodies : Registry.BodyHistories)
+	{
+		Bodies.TrimTail(RecordingClock);
+	}
+
+	// The index still holds where the actors went in the time playback took back.
+	HistoryIndex.DiscardAfter(RecordingClock);
+	for (auto& Cursor : Registry.IndexCursors)
+	{
+		Cursor = FRewindIndexCursor();
+	}
+
+	// Recording spills newer chunks behind the one being mapped, which then is no longer the next one playback needs.
+	for (auto& Spill : Registry.Spills)
+	{
+		Spill.Prefetch = TFuture<TUniquePtr<FRewindMappedChunk>>();
+	}
+
 	TRACE_BOOKMARK(TEXT("URewindSubsystem::EndReverse"))
-	
+
+	FRegistryIterationScope IterationScope{*this};
+
 	//OnEndReverse.Broadcast();
-    
-	for (auto& Actor :ReverseActors)
-	{
-		if (!Actor.IsValid()) continue;
 
-		Actor.InRewindComponent->bReversingTime=false;
-		Actor.InRewindComponent->OnEndReverseTime.Broadcast();
+	for (int32 Slot = 0; Slot < Registry.Num(); ++Slot)
+	{
+		Registry.Components[Slot]->bReversingTime=false;
+		Registry.Components[Slot]->OnEndReverseTime.Broadcast();
 	}
 }
@@ -0,0 +1,114 @@
+﻿#include "RewindTimelineFile.h"
+
+namespace RewindTimelineFile
+{
+	static void SerializeFormat(FArchive& Ar, FRewindHistoryFormat& Format)
+	{
+		Ar << Format.Compression;
+		Ar << Format.MaxQuantizationError;
+		Ar << Format.QuantizationOrigin;
+		Ar << Format.bPackedPoseHasScale;
+		Ar << Format.PoseBoneCount;
+	}
+
+	FRewindTimelineHeader MakeHeader()
+	{
+		FRewindTimelineHeader Header;
+		Header.Magic = Magic;
+		Header.Version = static_cast<uint32>(ERewindTimelineVersion::Latest);
+		Header.FrameSize = sizeof(FActorFrameSnapshot);
+		Header.PackedFrameSize = sizeof(FPackedActorFrameSnapshot);
+		Header.TransformSize = sizeof(FTransform);
+		return Header;
+	}
+
+	void SerializeHeader(FArchive& Ar, FRewindTimelineHeader& Header)
+	{
+		Ar << Header.Magic;
+		Ar << Header.Version;
+		Ar << Header.FrameSize;
+		Ar << Header.PackedFrameSize;
+		Ar << Header.TransformSize;
+		if (Ar.IsLoading() && !IsCompatible(Header))
+		{
+			Ar.SetError();
+			return;
+		}
+
+		Ar << Header.RecordingClock;
+
+		int32 NumLayouts{Header.Layouts.Num()};
+		Ar << NumLayouts;
+		if (Ar.IsLoading())
+		{
+			if (NumLayouts < 0 || Ar.IsError())
+			{
+				Ar.SetError();
+				return;
+			}
+			Header.Layouts.SetNum(NumLayouts);
+		}
+		for (auto& Layout : Header.Layouts)
+		{
+			Ar << Layout.SkeletalMeshName;
+			Ar << Layout.BoneNames;
+			Ar << Layout.ParentIndices;
+		}
+
+		int32 NumActors{Header.Actors.Num()};
+		Ar << NumActors;
+		if (Ar.IsLoading())
+		{
+			if (NumActors < 0 || Ar.IsError())
+			{
+				Ar.SetError();
+				return;
+			}
+			Header.Actors.SetNum(NumActors);
+		}
+		for (auto& Entry : Header.Actors)
+		{
+			Ar << Entry.ActorPath;
+			SerializeFormat(Ar, Entry.Format);
+			Ar << Entry.PoseLayoutId;
+			Ar << Entry.NumFrames;
+			Ar << Entry.Offset;
+			Ar << Entry.Size;
+		}
+	}
+
+	bool IsCompatible(const FRewindTimelineHeader& Header)
+	{
+		return Header.Magic == Magic
+			&& Header.Version == static_cast<uint32>(ERewindTimelineVersion::Latest)
+			&& Header.FrameSize == sizeof(FActorFrameSnapshot)
+			&& Header.PackedFrameSize == sizeof(FPackedActorFrameSnapshot)
+			&& Header.TransformSize == sizeof(FTransform);
+	}
+
+	bool IsValid(const FRewindTimelineHeader& Header, int64 PayloadSize)
+	{
+		for (const auto& Layout : Header.Layouts)
+		{
+			if (Layout.ParentIndices.Num() != Layout.BoneNames.Num()) return false;
+		}
+
+		for (const auto& Entry : Header.Actors)
+		{
+			const auto& Format = Entry.Format;
+			if (Format.Compression != ERewindFrameCompression::None && Format.Compression != ERewindFrameCompression::Quantized) return false;
+			if (!FMath::IsFinite(Format.MaxQuantizationError) || Format.MaxQuantizationError < 0.f || Format.QuantizationOrigin.ContainsNaN()) return false;
+
+			// Poses are recorded against the actor's layout, so the bone count is the one of its table entry.
+			if (Entry.PoseLayoutId != INDEX_NONE && !Header.Layouts.IsValidIndex(Entry.PoseLayoutId)) return false;
+			const int32 LayoutBoneCount{Entry.PoseLayoutId != INDEX_NONE ? Header.Layouts[Entry.PoseLayoutId].Num() : 0};
+			if (Format.PoseBoneCount != LayoutBoneCount) return false;
+
+			// Frame count is checked against the payload before it is multiplied, so the size can't overflow.
+			const int64 FrameBytes{Format.GetFrameBytes()};
+			if (Entry.NumFrames < 0 || Entry.NumFrames > PayloadSize / FrameBytes || Entry.Size != Entry.NumFrames * FrameBytes) return false;
+			if (Entry.Offset < 0 || Entry.Offset > PayloadSize - Entry.Size) return false;
+		}
+		return true;
+	}
+}
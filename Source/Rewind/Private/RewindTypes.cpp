@@ -1,3 +1,627 @@
 ﻿
 
-#include "RewindTypes.h"
\ No newline at end of file
+#include "RewindTypes.h"
+
+#include "RewindStats.h"
+
+FRewindedActorFrameSnapshot InterpolateFrames(const FActorFrameSnapshot& Right, const FActorFrameSnapshot& Left, float Fraction)
+{
+	const FQuat LeftRotation{Left.Rotation.Quaternion()};
+	const FQuat RightRotation{Right.Rotation.Quaternion()};
+
+	FRewindedActorFrameSnapshot Result{
+		FMath::Lerp(Right.Location, Left.Location, Fraction),
+		FQuat::Slerp(RightRotation, LeftRotation, Fraction).Rotator(),
+		FMath::Lerp(Right.LinearVelocity, Left.LinearVelocity, Fraction),
+		FMath::Lerp(Right.AngularVelocity, Left.AngularVelocity, Fraction)
+	};
+
+	// Hermite runs in recording order: from Left (T = 0) to Right (T = 1), tangents are velocity * interval.
+	const float Interval{Right.DeltaTime};
+	const float T{1.f - Fraction};
+	const float T2{T * T};
+	const float T3{T2 * T};
+	const float H10{T3 - 2.f * T2 + T};
+	const float H01{-2.f * T3 + 3.f * T2};
+	const float H11{T3 - T2};
+
+	if (Left.bHasLinearVelocity && Right.bHasLinearVelocity)
+	{
+		const float H00{2.f * T3 - 3.f * T2 + 1.f};
+		Result.Location = H00 * Left.Location + H10 * Interval * Left.LinearVelocity + H01 * Right.Location + H11 * Interval * Right.LinearVelocity;
+	}
+
+	if (Left.bHasAngularVelocity && Right.bHasAngularVelocity)
+	{
+		// Same curve on the rotation vector of the world-space delta from Left, which starts at zero.
+		FQuat Delta{RightRotation * LeftRotation.Inverse()};
+		Delta.EnforceShortestArcWith(FQuat::Identity);
+		const FVector RotationVector{H10 * Interval * Left.AngularVelocity + H01 * Delta.ToRotationVector() + H11 * Interval * Right.AngularVelocity};
+		Result.Rotation = (FQuat::MakeFromRotationVector(RotationVector) * LeftRotation).Rotator();
+	}
+
+	return Result;
+}
+
+int64 FRewindHistoryFormat::GetFrameBytes() const
+{
+	return Compression == ERewindFrameCompression::None
+		? sizeof(FActorFrameSnapshot) + PoseBoneCount * static_cast<int64>(sizeof(FTransform))
+		: sizeof(FPackedActorFrameSnapshot) + PoseBoneCount * static_cast<int64>(RewindCompression::GetPackedBoneSize(bPackedPoseHasScale));
+}
+
+void FActorData::SetCompression(ERewindFrameCompression InCompression, float InMaxError)
+{
+	InMaxError = FMath::Max(InMaxError, UE_KINDA_SMALL_NUMBER);
+	if (InCompression == Compression && InMaxError == MaxQuantizationError)
+	{
+		return;
+	}
+
+	ResetFrames();
+	Compression = InCompression;
+	MaxQuantizationError = InMaxError;
+	bPackedPoseHasScale = false;
+	PackedFrames.SetPoseStride(PoseBoneCount * RewindCompression::GetPackedBoneSize(bPackedPoseHasScale));
+}
+
+void FActorData::SetPoseBoneCount(int32 InNumBones)
+{
+	if (InNumBones == PoseBoneCount)
+	{
+		return;
+	}
+
+	ResetFrames();
+	PoseBoneCount = InNumBones;
+	StoredFrames.SetPoseStride(PoseBoneCount);
+	PackedFrames.SetPoseStride(PoseBoneCount * RewindCompression::GetPackedBoneSize(bPackedPoseHasScale));
+}
+
+void FActorData::ReserveFrames(int32 InCapacity)
+{
+	if (IsCompressed())
+	{
+		PackedFrames.Reserve(InCapacity);
+	}
+	else
+	{
+		StoredFrames.Reserve(InCapacity);
+	}
+}
+
+void FActorData::PopHeadFrame()
+{
+	RecordedTime -= GetFrameDeltaTime(0);
+	if (IsCompressed())
+	{
+		PackedFrames.PopHead();
+	}
+	else
+	{
+		StoredFrames.PopHead();
+	}
+}
+
+void FActorData::PopTailFrame()
+{
+	RecordedTime -= GetFrameDeltaTime(NumFrames() - 1);
+	if (IsCompressed())
+	{
+		PackedFrames.PopTail();
+	}
+	else
+	{
+		StoredFrames.PopTail();
+	}
+}
+
+void FActorData::ResetFrames()
+{
+	StoredFrames.Reset();
+	PackedFrames.Reset();
+	RecordedTime = 0.f;
+}
+
+void FActorData::TrimHead(float MaxRecordedTime)
+{
+	while (RecordedTime > MaxRecordedTime && HasFrames())
+	{
+		PopHeadFrame();
+	}
+}
+
+FRewindHistoryFormat FActorData::GetFormat() const
+{
+	FRewindHistoryFormat Format;
+	Format.Compression = Compression;
+	Format.MaxQuantizationError = MaxQuantizationError;
+	Format.QuantizationOrigin = QuantizationOrigin;
+	Format.bPackedPoseHasScale = bPackedPoseHasScale;
+	Format.PoseBoneCount = PoseBoneCount;
+	return Format;
+}
+
+void FActorData::WriteHeadFrames(int32 InNumFrames, TArray<uint8>& OutBytes) const
+{
+	check(InNumFrames <= NumFrames());
+
+	const int32 Offset{OutBytes.Num()};
+	OutBytes.AddUninitialized(InNumFrames * GetFrameBytes());
+	CopyHeadFrames(InNumFrames, OutBytes.GetData() + Offset);
+}
+
+void FActorData::CopyHeadFrames(int32 InNumFrames, uint8* Out) const
+{
+	check(InNumFrames <= NumFrames());
+
+	if (IsCompressed())
+	{
+		PackedFrames.CopyRawFrames(0, InNumFrames, Out);
+	}
+	else
+	{
+		StoredFrames.CopyRawFrames(0, InNumFrames, Out);
+	}
+}
+
+bool FActorData::PrependFrames(const FRewindHistoryFormat& InFormat, TConstArrayView<uint8> Bytes, int32 InNumFrames)
+{
+	// Frames written before the history took on a scale channel are widened to it.
+	FRewindHistoryFormat NarrowFormat{GetFormat()};
+	NarrowFormat.bPackedPoseHasScale = false;
+	if (bPackedPoseHasScale && InFormat == NarrowFormat && Bytes.Num() == InNumFrames * InFormat.GetFrameBytes())
+	{
+		const int32 FramesBytes{InNumFrames * static_cast<int32>(sizeof(FPackedActorFrameSnapshot))};
+		const int32 NarrowStride{PoseBoneCount * RewindCompression::GetPackedBoneSize(false)};
+		const int32 WideStride{PackedFrames.GetPoseStride()};
+		TArray<uint8> Widened;
+		Widened.SetNumUninitialized(InNumFrames * static_cast<int32>(GetFrameBytes()));
+		FMemory::Memcpy(Widened.GetData(), Bytes.GetData(), FramesBytes);
+		for (int32 Index = 0; Index < InNumFrames; ++Index)
+		{
+			RewindCompression::WidenPose(Bytes.Slice(FramesBytes + Index * NarrowStride, NarrowStride), PoseBoneCount,
+				TArrayView<uint8>(Widened).Slice(FramesBytes + Index * WideStride, WideStride));
+		}
+		return PrependFrames(GetFormat(), Widened, InNumFrames);
+	}
+
+	if (InFormat != GetFormat() || Bytes.Num() != InNumFrames * GetFrameBytes())
+	{
+		return false;
+	}
+
+	if (IsCompressed())
+	{
+		PackedFrames.PrependRawFrames(Bytes.GetData(), InNumFrames);
+	}
+	else
+	{
+		StoredFrames.PrependRawFrames(Bytes.GetData(), InNumFrames);
+	}
+
+	for (int32 Index = 0; Index < InNumFrames; ++Index)
+	{
+		RecordedTime += GetFrameDeltaTime(Index);
+	}
+	return true;
+}
+
+bool FActorData::RestoreFrames(const FRewindHistoryFormat& InFormat, TConstArrayView<uint8> Bytes, int32 InNumFrames)
+{
+	ResetToFormat(InFormat);
+	return PrependFrames(InFormat, Bytes, InNumFrames);
+}
+
+void FActorData::ResetToFormat(const FRewindHistoryFormat& InFormat)
+{
+	SetCompression(InFormat.Compression, InFormat.MaxQuantizationError);
+	SetPoseBoneCount(InFormat.PoseBoneCount);
+	ResetFrames();
+
+	bPackedPoseHasScale = InFormat.bPackedPoseHasScale;
+	PackedFrames.SetPoseStride(PoseBoneCount * RewindCompression::GetPackedBoneSize(bPackedPoseHasScale));
+	QuantizationOrigin = InFormat.QuantizationOrigin;
+}
+
+void FActorData::WidenPackedPoses()
+{
+	check(!bPackedPoseHasScale);
+
+	TRewindFrameStore<FPackedActorFrameSnapshot, uint8> Widened;
+	Widened.SetPoseStride(PoseBoneCount * RewindCompression::GetPackedBoneSize(true));
+	Widened.Reserve(PackedFrames.Capacity());
+	for (int32 Index = 0; Index < PackedFrames.Num(); ++Index)
+	{
+		Widened.AddTail_GetRef() = PackedFrames[Index];
+		RewindCompression::WidenPose(PackedFrames.GetPose(Index), PoseBoneCount, Widened.GetPose(Index));
+	}
+
+	PackedFrames = MoveTemp(Widened);
+	bPackedPoseHasScale = true;
+}
+
+template<typename FrameStoreType>
+static void CopyFrameWithPose(const FrameStoreType& From, int32 FromIndex, FrameStoreType& To, int32 ToIndex)
+{
+	To[ToIndex] = From[FromIndex];
+	const auto Pose{From.GetPose(FromIndex)};
+	if (!Pose.IsEmpty())
+	{
+		FMemory::Memcpy(To.GetPose(ToIndex).GetData(), Pose.GetData(), Pose.NumBytes());
+	}
+}
+
+void FActorData::MoveTailFrameTo(FActorData& Other)
+{
+	check(HasFrames());
+
+	const FRewindHistoryFormat Format{GetFormat()};
+	if (Other.GetFormat() != Format)
+	{
+		Other.ResetToFormat(Format);
+	}
+
+	const int32 Tail{NumFrames() - 1};
+	if (IsCompressed())
+	{
+		Other.PackedFrames.AddHead_GetRef();
+		CopyFrameWithPose(PackedFrames, Tail, Other.PackedFrames, 0);
+	}
+	else
+	{
+		Other.StoredFrames.AddHead_GetRef();
+		CopyFrameWithPose(StoredFrames, Tail, Other.StoredFrames, 0);
+	}
+	Other.RecordedTime += GetFrameDeltaTime(Tail);
+	PopTailFrame();
+}
+
+bool FActorData::MoveHeadFrameFrom(FActorData& Other)
+{
+	check(Other.HasFrames());
+
+	const FRewindHistoryFormat Format{Other.GetFormat()};
+	if (GetFormat() != Format)
+	{
+		if (HasFrames()) return false;
+		ResetToFormat(Format);
+	}
+
+	if (IsCompressed())
+	{
+		PackedFrames.AddTail_GetRef();
+		CopyFrameWithPose(Other.PackedFrames, 0, PackedFrames, PackedFrames.Num() - 1);
+	}
+	else
+	{
+		StoredFrames.AddTail_GetRef();
+		CopyFrameWithPose(Other.StoredFrames, 0, StoredFrames, StoredFrames.Num() - 1);
+	}
+	RecordedTime += Other.GetFrameDeltaTime(0);
+	Other.PopHeadFrame();
+	return true;
+}
+
+void FActorData::RemapPoseLayoutIds(TConstArrayView<int32> LayoutIdMap)
+{
+	for (int32 Index = 0; Index < NumFrames(); ++Index)
+	{
+		int32& LayoutId = IsCompressed() ? PackedFrames[Index].PoseLayoutId : StoredFrames[Index].PoseLayoutId;
+		LayoutId = LayoutIdMap.IsValidIndex(LayoutId) ? LayoutIdMap[LayoutId] : INDEX_NONE;
+	}
+}
+
+template<typename FrameStoreType>
+static int32 ThinFrameStore(FrameStoreType& Store, double BeforeTimestamp, float MaxInterval)
+{
+	// Number of frames recorded before the cutoff
+	int32 Low{0};
+	int32 High{Store.Num()};
+	while (Low < High)
+	{
+		const int32 Middle{Low + (High - Low) / 2};
+		if (Store[Middle].Timestamp < BeforeTimestamp)
+		{
+			Low = Middle + 1;
+		}
+		else
+		{
+			High = Middle;
+		}
+	}
+
+	const int32 NumOld{Low};
+	if (NumOld < 3)
+	{
+		return 0;
+	}
+
+	// Walk back from the newest old frame, which is always kept. Kept frames are compacted toward it and the freed
+	// slots end up at the head.
+	int32 KeptIndex{NumOld - 1};
+	bool bDropNext{true};
+	for (int32 Index = NumOld - 2; Index >= 0; --Index)
+	{
+		auto& Kept = Store[KeptIndex];
+		if (bDropNext && Kept.DeltaTime + Store[Index].DeltaTime <= MaxInterval)
+		{
+			Kept.DeltaTime += Store[Index].DeltaTime;
+			bDropNext = false;
+			continue;
+		}
+
+		--KeptIndex;
+		if (KeptIndex != Index)
+		{
+			Store.CopyFrame(Index, KeptIndex);
+		}
+		bDropNext = true;
+	}
+
+	for (int32 Index = 0; Index < KeptIndex; ++Index)
+	{
+		Store.PopHead();
+	}
+	return KeptIndex;
+}
+
+int32 FActorData::ThinFrames(double BeforeTimestamp, float MaxInterval)
+{
+	// Dropped frames' time moves into the kept ones, so RecordedTime is untouched.
+	return IsCompressed() ? ThinFrameStore(PackedFrames, BeforeTimestamp, MaxInterval) : ThinFrameStore(StoredFrames, BeforeTimestamp, MaxInterval);
+}
+
+void FActorData::AddFrame(const FActorFrameSnapshot& Frame, TConstArrayView<FTransform> Pose)
+{
+	check(Pose.IsEmpty() || Pose.Num() == PoseBoneCount);
+
+	if (!IsCompressed())
+	{
+		StoredFrames.AddTail_GetRef() = Frame;
+		if (!Pose.IsEmpty())
+		{
+			FMemory::Memcpy(StoredFrames.GetPose(StoredFrames.Num() - 1).GetData(), Pose.GetData(), Pose.Num() * sizeof(FTransform));
+		}
+		RecordedTime += Frame.DeltaTime;
+		return;
+	}
+
+	if (PackedFrames.IsEmpty())
+	{
+		QuantizationOrigin = Frame.Location;
+	}
+
+	auto& Packed = PackedFrames.AddTail_GetRef();
+	TArrayView<uint8> PackedPose{PackedFrames.GetPose(PackedFrames.Num() - 1)};
+	if (!RewindCompression::EncodeFrame(Frame, Pose, QuantizationOrigin, MaxQuantizationError, bPackedPoseHasScale, Packed,
+		Pose.IsEmpty() ? TArrayView<uint8>() : PackedPose))
+	{
+		// Scale is left out of packed poses until an actor actually uses one. The frames recorded before then get a unit scale.
+		PackedFrames.PopTail();
+		WidenPackedPoses();
+		auto& Widened = PackedFrames.AddTail_GetRef();
+		RewindCompression::EncodeFrame(Frame, Pose, QuantizationOrigin, MaxQuantizationError, bPackedPoseHasScale, Widened,
+			PackedFrames.GetPose(PackedFrames.Num() - 1));
+	}
+	RecordedTime += Frame.DeltaTime;
+}
+
+void FActorData::AddKeyframe(const FActorFrameSnapshot& Frame, TConstArrayView<FTransform> Pose,
+	const FRewindKeyframeReduction& Reduction, FRewindScratch& Scratch)
+{
+	if (!Reduction.bEnabled || !CanDropTail(Frame, Pose, Reduction, Scratch))
+	{
+		AddFrame(Frame, Pose);
+		return;
+	}
+
+	FActorFrameSnapshot Stretched{Frame};
+	Stretched.DeltaTime += GetFrameDeltaTime(NumFrames() - 1);
+	PopTailFrame();
+	AddFrame(Stretched, Pose);
+}
+
+bool FActorData::CanDropTail(const FActorFrameSnapshot& Next, TConstArrayView<FTransform> NextPose,
+	const FRewindKeyframeReduction& Reduction, FRewindScratch& Scratch) const
+{
+	const int32 Num{NumFrames()};
+	if (Num < 2)
+	{
+		return false;
+	}
+
+	const FActorFrameSnapshot& Tail{GetFrame(Num - 1, Scratch.Frames[0])};
+	const float Span{Tail.DeltaTime + Next.DeltaTime};
+	if (Span > Reduction.MaxKeyframeInterval || Span <= 0.f)
+	{
+		return false;
+	}
+
+	const FActorFrameSnapshot& Previous{GetFrame(Num - 2, Scratch.Frames[1])};
+	if (Tail.PoseLayoutId != Next.PoseLayoutId || Tail.PoseLayoutId != Previous.PoseLayoutId)
+	{
+		return false;
+	}
+
+	// Rebuild the tail the way playback would once it is gone: Next becomes the right frame, Previous the left one.
+	FActorFrameSnapshot StretchedNext{Next};
+	StretchedNext.DeltaTime = Span;
+	const float Fraction{Next.DeltaTime / Span};
+	const FRewindedActorFrameSnapshot Rebuilt{InterpolateFrames(StretchedNext, Previous, Fraction)};
+	const float RotationTolerance{FMath::DegreesToRadians(Reduction.RotationTolerance)};
+
+	if (FVector::DistSquared(Rebuilt.Location, Tail.Location) > FMath::Square(Reduction.PositionTolerance)
+		|| Rebuilt.Rotation.Quaternion().AngularDistance(Tail.Rotation.Quaternion()) > RotationTolerance
+		|| FVector::DistSquared(Rebuilt.LinearVelocity, Tail.LinearVelocity) > FMath::Square(Reduction.LinearVelocityTolerance)
+		|| FVector::DistSquared(Rebuilt.AngularVelocity, Tail.AngularVelocity) > FMath::Square(Reduction.AngularVelocityTolerance))
+	{
+		return false;
+	}
+
+	if (Tail.PoseLayoutId == INDEX_NONE)
+	{
+		return true;
+	}
+
+	const TConstArrayView<FTransform> TailPose{GetPose(Num - 1, Scratch.Poses[0])};
+	const TConstArrayView<FTransform> PreviousPose{GetPose(Num - 2, Scratch.Poses[1])};
+	for (int32 BoneIndex = 0; BoneIndex < TailPose.Num(); ++BoneIndex)
+	{
+		const FVector RebuiltLocation{FMath::Lerp(NextPose[BoneIndex].GetLocation(), PreviousPose[BoneIndex].GetLocation(), Fraction)};
+		const FQuat RebuiltRotation{FQuat::Slerp(NextPose[BoneIndex].GetRotation(), PreviousPose[BoneIndex].GetRotation(), Fraction)};
+
+		if (FVector::DistSquared(RebuiltLocation, TailPose[BoneIndex].GetLocation()) > FMath::Square(Reduction.PositionTolerance)
+			|| RebuiltRotation.AngularDistance(TailPose[BoneIndex].GetRotation()) > RotationTolerance)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+void FActorData::RecordFrame(const FActorFrameSnapshot& Frame, TConstArrayView<FTransform> Pose, float MaxRecordedTime,
+	const FRewindKeyframeReduction& Reduction, FRewindScratch& Scratch)
+{
+	{
+		SCOPE_CYCLE_COUNTER(STAT_RewindTrim);
+		while (RecordedTime >= MaxRecordedTime && HasFrames())
+		{
+			PopHeadFrame();
+		}
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_RewindStore);
+	AddKeyframe(Frame, Pose, Reduction, Scratch);
+}
+
+bool FActorData::StepPlayback(FRewindPlaybackCursor& Cursor, float Step, int32& OutLeftIndex, int32& OutRightIndex,
+	float& OutFraction, bool& bOutExhausted, FActorData* Future)
+{
+	bOutExhausted = NumFrames() < 2;
+	if (bOutExhausted)
+	{
+		return false;
+	}
+
+	// Right is always the tail and Left the frame before it; passed frames are taken off the tail.
+	Cursor.RunningTime += Step;
+	Cursor.LeftRunningTime = Cursor.RightRunningTime + GetFrameDeltaTime(NumFrames() - 1);
+
+	// The last pair is never taken, the cursor holds on the oldest frame instead.
+	while (Cursor.RunningTime > Cursor.LeftRunningTime && NumFrames() > 2)
+	{
+		Cursor.RightRunningTime += GetFrameDeltaTime(NumFrames() - 1);
+		Cursor.LeftRunningTime += GetFrameDeltaTime(NumFrames() - 2);
+
+		if (Future)
+		{
+			MoveTailFrameTo(*Future);
+		}
+		else
+		{
+			PopTailFrame();
+		}
+	}
+	bOutExhausted = NumFrames() <= 2;
+	Cursor.RunningTime = FMath::Min(Cursor.RunningTime, Cursor.LeftRunningTime);
+
+	if (Cursor.RunningTime < Cursor.RightRunningTime)
+	{
+		return false;
+	}
+
+	OutRightIndex = NumFrames() - 1;
+	OutLeftIndex = NumFrames() - 2;
+	const float Interval{Cursor.LeftRunningTime - Cursor.RightRunningTime};
+	OutFraction = Interval > 0.f ? (Cursor.RunningTime - Cursor.RightRunningTime) / Interval : 0.f;
+	return true;
+}
+
+bool FActorData::StepReplay(FRewindPlaybackCursor& Cursor, float Step, FActorData& Future, int32& OutLeftIndex,
+	int32& OutRightIndex, float& OutFraction, bool& bOutExhausted)
+{
+	// Right is the tail again, each frame the cursor moves past it towards the present comes back from Future.
+	Cursor.RunningTime -= Step;
+	while (Cursor.RunningTime < Cursor.RightRunningTime && Future.HasFrames())
+	{
+		const float DeltaTime{Future.GetFrameDeltaTime(0)};
+		if (!MoveHeadFrameFrom(Future))
+		{
+			Future.ResetFrames();
+			break;
+		}
+		Cursor.RightRunningTime -= DeltaTime;
+	}
+
+	bOutExhausted = !Future.HasFrames() && Cursor.RunningTime <= Cursor.RightRunningTime + UE_KINDA_SMALL_NUMBER;
+	if (NumFrames() < 2)
+	{
+		return false;
+	}
+
+	Cursor.LeftRunningTime = Cursor.RightRunningTime + GetFrameDeltaTime(NumFrames() - 1);
+	Cursor.RunningTime = FMath::Clamp(Cursor.RunningTime, Cursor.RightRunningTime, Cursor.LeftRunningTime);
+
+	OutRightIndex = NumFrames() - 1;
+	OutLeftIndex = NumFrames() - 2;
+	const float Interval{Cursor.LeftRunningTime - Cursor.RightRunningTime};
+	OutFraction = Interval > 0.f ? (Cursor.RunningTime - Cursor.RightRunningTime) / Interval : 0.f;
+	return true;
+}
+
+bool FActorData::FindBracket(double Time, int32& OutLeftIndex, int32& OutRightIndex, float& OutFraction) const
+{
+	const int32 Num{NumFrames()};
+	if (Num < 2)
+	{
+		return false;
+	}
+
+	// First frame recorded after Time, kept inside [1, Num - 1] so it always has a left neighbour.
+	int32 Low{1};
+	int32 High{Num - 1};
+	while (Low < High)
+	{
+		const int32 Middle{Low + (High - Low) / 2};
+		if (GetFrameTimestamp(Middle) < Time)
+		{
+			Low = Middle + 1;
+		}
+		else
+		{
+			High = Middle;
+		}
+	}
+
+	OutRightIndex = Low;
+	OutLeftIndex = Low - 1;
+
+	const double RightTime{GetFrameTimestamp(OutRightIndex)};
+	const double Interval{RightTime - GetFrameTimestamp(OutLeftIndex)};
+	OutFraction = Interval > 0.0 ? static_cast<float>(FMath::Clamp((RightTime - Time) / Interval, 0.0, 1.0)) : 0.f;
+	return true;
+}
+
+const FActorFrameSnapshot& FActorData::GetFrame(int32 Index, FActorFrameSnapshot& Scratch) const
+{
+	if (!IsCompressed())
+	{
+		return StoredFrames[Index];
+	}
+
+	RewindCompression::DecodeFrame(PackedFrames[Index], QuantizationOrigin, MaxQuantizationError, Scratch);
+	return Scratch;
+}
+
+TConstArrayView<FTransform> FActorData::GetPose(int32 Index, TArray<FTransform>& Scratch) const
+{
+	if (!IsCompressed())
+	{
+		return StoredFrames.GetPose(Index);
+	}
+
+	Scratch.SetNumUninitialized(PoseBoneCount, EAllowShrinking::No);
+	RewindCompression::DecodePose(PackedFrames[Index], PackedFrames.GetPose(Index), bPackedPoseHasScale, Scratch);
+	return Scratch;
+}
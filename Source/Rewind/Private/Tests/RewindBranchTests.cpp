@@ -0,0 +1,167 @@
+﻿#include "RewindBranchTree.h"
+
+#include "GameFramework/Actor.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_AUTOMATION_TESTS
+namespace RewindBranchTests
+{
+	static constexpr float DeltaTime{1.f / 60.f};
+
+	static double GetTimestamp(int32 Index)
+	{
+		return Index * static_cast<double>(DeltaTime);
+	}
+
+	//Records frames up to and including LastIndex, tagged with the timeline that recorded them
+	static void RecordTo(FActorData& Data, int32 LastIndex, int32 Timeline)
+	{
+		const FRewindKeyframeReduction Reduction;
+		FRewindScratch Scratch;
+		for (int32 Index = Data.HasFrames() ? FMath::RoundToInt32(Data.GetFrameTimestamp(Data.NumFrames() - 1) / DeltaTime) + 1 : 0; Index <= LastIndex; ++Index)
+		{
+			FActorFrameSnapshot Frame{FVector(Index * 10.0, Timeline, 0.0), FRotator::ZeroRotator, FVector::ZeroVector, FVector::ZeroVector, DeltaTime};
+			Frame.Timestamp = GetTimestamp(Index);
+			Data.RecordFrame(Frame, {}, MAX_flt, Reduction, Scratch);
+		}
+	}
+
+	//Goes back to Index the way playback does, moving the newer frames into the future
+	static void RewindTo(FActorData& Data, FActorData& Future, int32 Index)
+	{
+		while (Data.GetFrameTimestamp(Data.NumFrames() - 1) > GetTimestamp(Index))
+		{
+			Data.MoveTailFrameTo(Future);
+		}
+	}
+
+	//Timeline the history should hold, as the tag of each frame from index 0 on
+	static bool TestTimeline(FAutomationTestBase& Test, const TCHAR* What, const FActorData& Data, TConstArrayView<int32> ExpectedTimelines)
+	{
+		if (!Test.TestEqual(FString::Printf(TEXT("%s frame count"), What), Data.NumFrames(), ExpectedTimelines.Num())) return false;
+
+		FActorFrameSnapshot Scratch;
+		for (int32 Index = 0; Index < Data.NumFrames(); ++Index)
+		{
+			const FActorFrameSnapshot& Frame{Data.GetFrame(Index, Scratch)};
+			if (!Test.TestTrue(FString::Printf(TEXT("%s frame %d is at its time"), What, Index), FMath::IsNearlyEqual(Frame.Timestamp, GetTimestamp(Index)))
+				|| !Test.TestEqual(FString::Printf(TEXT("%s frame %d is from timeline"), What, Index), FMath::RoundToInt32(Frame.Location.Y), ExpectedTimelines[Index]))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FRewindBranchNestedForkTest, "Rewind.Branches.NestedFork", EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FRewindBranchNestedForkTest::RunTest(const FString& Parameters)
+{
+	using namespace RewindBranchTests;
+
+	const TArray<TObjectKey<AActor>> Actors{GetDefault<AActor>()};
+	TArray<FActorData> Histories;
+	TArray<FActorData> Futures;
+	Histories.SetNum(1);
+	Futures.SetNum(1);
+	FRewindBranchTree Tree;
+
+	// Timeline 0 records 0..10 and is left at 6. Timeline 1 records 7..12 and is left at 3. Timeline 2 records 4..8.
+	RecordTo(Histories[0], 10, 0);
+	RewindTo(Histories[0], Futures[0], 6);
+	Tree.Fork(GetTimestamp(6), Actors, Futures, 4);
+	RecordTo(Histories[0], 12, 1);
+	RewindTo(Histories[0], Futures[0], 3);
+	Tree.Fork(GetTimestamp(3), Actors, Futures, 4);
+	RecordTo(Histories[0], 8, 2);
+
+	TestEqual(TEXT("Both forks are kept"), Tree.GetBranches().Num(), 2);
+	TestEqual(TEXT("Live timeline id"), Tree.GetCurrentId(), 2);
+	TestFalse(TEXT("Futures are handed over"), Futures[0].HasFrames());
+
+	const auto Expected = [](std::initializer_list<int32> RunEnds, std::initializer_list<int32> RunTimelines)
+	{
+		TArray<int32> Result;
+		const int32* Timeline{RunTimelines.begin()};
+		for (const int32 RunEnd : RunEnds)
+		{
+			while (Result.Num() <= RunEnd)
+			{
+				Result.Add(*Timeline);
+			}
+			++Timeline;
+		}
+		return Result;
+	};
+
+	// The first timeline's frames 4..6 went into the second fork along with timeline 1's, they come back through it.
+	double ForkTimestamp{0.0};
+	TestTrue(TEXT("Switches to the first fork"), Tree.SwitchTo(0, Actors, Histories, ForkTimestamp));
+	TestTimeline(*this, TEXT("Timeline 0"), Histories[0], Expected({10}, {0}));
+	TestTrue(TEXT("Rebuilt from the earliest fork on the way"), FMath::IsNearlyEqual(ForkTimestamp, GetTimestamp(3)));
+	TestEqual(TEXT("Timeline 0 is live"), Tree.GetCurrentId(), 0);
+
+	TestTrue(TEXT("Switches to the second timeline"), Tree.SwitchTo(1, Actors, Histories, ForkTimestamp));
+	TestTimeline(*this, TEXT("Timeline 1"), Histories[0], Expected({6, 12}, {0, 1}));
+
+	TestTrue(TEXT("Switches to the third timeline"), Tree.SwitchTo(2, Actors, Histories, ForkTimestamp));
+	TestTimeline(*this, TEXT("Timeline 2"), Histories[0], Expected({3, 8}, {0, 2}));
+
+	TestTrue(TEXT("Switches back to the first fork"), Tree.SwitchTo(0, Actors, Histories, ForkTimestamp));
+	TestTimeline(*this, TEXT("Timeline 0 again"), Histories[0], Expected({10}, {0}));
+	TestEqual(TEXT("Every other timeline is still a branch"), Tree.GetBranches().Num(), 2);
+
+	TestFalse(TEXT("Unknown branches fail"), Tree.SwitchTo(7, Actors, Histories, ForkTimestamp));
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FRewindBranchRemoveOldestTest, "Rewind.Branches.RemoveOldest", EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FRewindBranchRemoveOldestTest::RunTest(const FString& Parameters)
+{
+	using namespace RewindBranchTests;
+
+	const TArray<TObjectKey<AActor>> Actors{GetDefault<AActor>()};
+	TArray<FActorData> Histories;
+	TArray<FActorData> Futures;
+	Histories.SetNum(1);
+	Futures.SetNum(1);
+	FRewindBranchTree Tree;
+
+	// Timeline 1 forks off timeline 0 at 6, then timeline 2 off timeline 1 at 9. Going back to timeline 0 leaves
+	// timeline 2 as a branch of it and timeline 1, which only differs from timeline 2 after 9, as a branch of that.
+	RecordTo(Histories[0], 10, 0);
+	RewindTo(Histories[0], Futures[0], 6);
+	Tree.Fork(GetTimestamp(6), Actors, Futures, 4);
+	RecordTo(Histories[0], 12, 1);
+	RewindTo(Histories[0], Futures[0], 9);
+	Tree.Fork(GetTimestamp(9), Actors, Futures, 4);
+	RecordTo(Histories[0], 11, 2);
+
+	double ForkTimestamp;
+	TestTrue(TEXT("Switches to the first fork"), Tree.SwitchTo(0, Actors, Histories, ForkTimestamp));
+	TestEqual(TEXT("Two branches"), Tree.GetBranches().Num(), 2);
+	TestTrue(TEXT("Branches count their frames"), Tree.GetMemoryBytes() > 0);
+
+	// The oldest branch is timeline 1, nothing forked off it. Timeline 2 still comes back whole without it.
+	TestEqual(TEXT("Oldest branch"), Tree.GetBranches()[0].Id, 1);
+	TestTrue(TEXT("Removes the oldest branch"), Tree.RemoveOldest());
+	TestEqual(TEXT("Its parent is kept"), Tree.GetBranches().Num(), 1);
+	TestFalse(TEXT("Removed branches are gone"), Tree.SwitchTo(1, Actors, Histories, ForkTimestamp));
+	TestTrue(TEXT("Switches to the third timeline"), Tree.SwitchTo(2, Actors, Histories, ForkTimestamp));
+	TestTimeline(*this, TEXT("Timeline 2"), Histories[0], {0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 2, 2});
+
+	TestTrue(TEXT("Removes the first timeline"), Tree.RemoveOldest());
+	TestFalse(TEXT("Nothing left to remove"), Tree.RemoveOldest());
+	TestEqual(TEXT("No branch memory left"), Tree.GetMemoryBytes(), static_cast<int64>(0));
+	TestEqual(TEXT("Live history untouched"), Histories[0].NumFrames(), 12);
+
+	// Without branches kept, the futures are just dropped.
+	RewindTo(Histories[0], Futures[0], 5);
+	Tree.Fork(GetTimestamp(5), Actors, Futures, 0);
+	TestTrue(TEXT("No branch is made"), Tree.GetBranches().IsEmpty());
+	TestFalse(TEXT("The future is dropped"), Futures[0].HasFrames());
+	return true;
+}
+#endif
@@ -0,0 +1,41 @@
+﻿#include "RewindHistoryIndex.h"
+
+#include "GameFramework/Actor.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_AUTOMATION_TESTS
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FRewindHistoryIndexWideSweepTest, "Rewind.HistoryIndex.WideSweep", EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FRewindHistoryIndexWideSweepTest::RunTest(const FString& Parameters)
+{
+	FRewindHistoryIndex Index;
+	Index.Configure(0.1f, 100.f, 2.f);
+
+	// An actor crossing a kilometre between two frames of the same bucket sweeps far more cells than are filled.
+	const TObjectKey<AActor> Actor{GetDefault<AActor>()};
+	const FBox Box{FVector(-50.0), FVector(50.0)};
+	FRewindIndexCursor Cursor;
+	Index.AddFrame(Actor, 0.0, Box, Cursor);
+	Index.AddFrame(Actor, 0.05, Box.ShiftBy(FVector(100000.0, 0.0, 0.0)), Cursor);
+
+	FRewindHistoryIndex::FCandidates Candidates;
+	Index.Gather(0.05, Box.ShiftBy(FVector(50000.0, 0.0, 0.0)), Candidates);
+	TestTrue(TEXT("Found halfway along the sweep"), Candidates.Contains(Actor));
+
+	Candidates.Reset();
+	Index.Gather(0.05, Box.ShiftBy(FVector(50000.0, 5000.0, 0.0)), Candidates);
+	TestFalse(TEXT("Not found off the sweep"), Candidates.Contains(Actor));
+
+	// The frame after the wide sweep is indexed in its cells again.
+	Index.AddFrame(Actor, 0.08, Box.ShiftBy(FVector(100010.0, 0.0, 0.0)), Cursor);
+	Candidates.Reset();
+	Index.Gather(0.08, Box.ShiftBy(FVector(100010.0, 0.0, 0.0)), Candidates);
+	TestTrue(TEXT("Found where it landed"), Candidates.Contains(Actor));
+
+	Index.DiscardAfter(-1.0);
+	Candidates.Reset();
+	Index.Gather(0.05, Box.ShiftBy(FVector(50000.0, 0.0, 0.0)), Candidates);
+	TestTrue(TEXT("Discarding drops the wide sweeps too"), Candidates.IsEmpty());
+	return true;
+}
+#endif
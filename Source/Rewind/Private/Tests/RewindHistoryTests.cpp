@@ -0,0 +1,268 @@
+﻿#include "RewindTypes.h"
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_AUTOMATION_TESTS
+namespace RewindHistoryTests
+{
+	static constexpr float DeltaTime{1.f / 60.f};
+
+	//Frame Index of an actor moving along X at 600 cm/s, recorded at 60 Hz
+	static FActorFrameSnapshot MakeFrame(int32 Index)
+	{
+		FActorFrameSnapshot Frame{
+			FVector(Index * 10.0, 0.0, 0.0),
+			FRotator(0.0, Index, 0.0),
+			FVector(600.0, 0.0, 0.0),
+			FVector::ZeroVector,
+			DeltaTime
+		};
+		Frame.Timestamp = Index * static_cast<double>(DeltaTime);
+		return Frame;
+	}
+
+	//History of NumFrames frames, the first at timestamp 0
+	static void Record(FActorData& Data, int32 NumFrames, FRewindScratch& Scratch)
+	{
+		const FRewindKeyframeReduction Reduction;
+		for (int32 Index = 0; Index < NumFrames; ++Index)
+		{
+			Data.RecordFrame(MakeFrame(Index), {}, MAX_flt, Reduction, Scratch);
+		}
+	}
+
+	static const TCHAR* CompressionName(ERewindFrameCompression Compression)
+	{
+		return Compression == ERewindFrameCompression::None ? TEXT("uncompressed") : TEXT("quantized");
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FRewindHistoryRecordFrameTest, "Rewind.History.RecordFrame", EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FRewindHistoryRecordFrameTest::RunTest(const FString& Parameters)
+{
+	using namespace RewindHistoryTests;
+
+	constexpr float Window{1.f};
+	const FRewindKeyframeReduction Reduction;
+	FRewindScratch Scratch;
+
+	for (const auto Compression : {ERewindFrameCompression::None, ERewindFrameCompression::Quantized})
+	{
+		FActorData Data;
+		Data.SetCompression(Compression, 0.01f);
+		for (int32 Index = 0; Index < 180; ++Index)
+		{
+			Data.RecordFrame(MakeFrame(Index), {}, Window, Reduction, Scratch);
+		}
+
+		const TCHAR* Name{CompressionName(Compression)};
+		TestTrue(FString::Printf(TEXT("%s history keeps about the window"), Name), FMath::Abs(Data.GetRecordedTime() - Window) <= DeltaTime + UE_KINDA_SMALL_NUMBER);
+		TestEqual(FString::Printf(TEXT("%s tail is the newest frame"), Name), Data.GetFrameTimestamp(Data.NumFrames() - 1), MakeFrame(179).Timestamp);
+		TestTrue(FString::Printf(TEXT("%s tail location"), Name), Data.GetFrame(Data.NumFrames() - 1, Scratch.Frames[0]).Location.Equals(MakeFrame(179).Location, 0.02));
+
+		for (int32 Index = 1; Index < Data.NumFrames(); ++Index)
+		{
+			if (!TestTrue(FString::Printf(TEXT("%s timestamps increase"), Name), Data.GetFrameTimestamp(Index) > Data.GetFrameTimestamp(Index - 1)))
+			{
+				break;
+			}
+		}
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FRewindHistoryStepPlaybackTest, "Rewind.History.StepPlayback", EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FRewindHistoryStepPlaybackTest::RunTest(const FString& Parameters)
+{
+	using namespace RewindHistoryTests;
+
+	FRewindScratch Scratch;
+
+	for (const auto Compression : {ERewindFrameCompression::None, ERewindFrameCompression::Quantized})
+	{
+		const TCHAR* Name{CompressionName(Compression)};
+		FActorData Data;
+		FActorData Future;
+		Data.SetCompression(Compression, 0.01f);
+		Record(Data, 20, Scratch);
+
+		// Half a frame per step, so every pair is visited and interpolated.
+		FRewindPlaybackCursor Cursor;
+		bool bExhausted{false};
+		double PreviousX{MAX_dbl};
+		for (int32 Step = 0; Step < 100 && !bExhausted; ++Step)
+		{
+			int32 LeftIndex, RightIndex;
+			float Fraction;
+			if (!TestTrue(FString::Printf(TEXT("%s step %d has a pair"), Name, Step), Data.StepPlayback(Cursor, DeltaTime * 0.5f, LeftIndex, RightIndex, Fraction, bExhausted, &Future)))
+			{
+				return true;
+			}
+
+			TestTrue(FString::Printf(TEXT("%s step %d indices"), Name, Step), LeftIndex >= 0 && RightIndex == LeftIndex + 1 && RightIndex < Data.NumFrames());
+			TestTrue(FString::Printf(TEXT("%s step %d fraction"), Name, Step), Fraction >= 0.f && Fraction <= 1.f);
+
+			const double X{InterpolateFrames(Data.GetFrame(RightIndex, Scratch.Frames[0]), Data.GetFrame(LeftIndex, Scratch.Frames[1]), Fraction).Location.X};
+			TestTrue(FString::Printf(TEXT("%s step %d goes back"), Name, Step), X <= PreviousX + 0.01);
+			PreviousX = X;
+		}
+
+		TestTrue(FString::Printf(TEXT("%s playback runs out"), Name), bExhausted);
+		TestEqual(FString::Printf(TEXT("%s keeps the last pair"), Name), Data.NumFrames(), 2);
+		TestEqual(FString::Printf(TEXT("%s passed frames go to the future"), Name), Future.NumFrames(), 18);
+		TestTrue(FString::Printf(TEXT("%s ends between the oldest two frames"), Name), PreviousX <= MakeFrame(1).Location.X + 0.02);
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FRewindHistoryStepPlaybackTwoFramesTest, "Rewind.History.StepPlaybackTwoFrames", EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FRewindHistoryStepPlaybackTwoFramesTest::RunTest(const FString& Parameters)
+{
+	using namespace RewindHistoryTests;
+
+	FRewindScratch Scratch;
+	FActorData Data;
+	Record(Data, 2, Scratch);
+
+	// Steps far past the oldest frame hold on it instead of taking the last pair apart.
+	FRewindPlaybackCursor Cursor;
+	for (int32 Step = 0; Step < 3; ++Step)
+	{
+		int32 LeftIndex{INDEX_NONE}, RightIndex{INDEX_NONE};
+		float Fraction{-1.f};
+		bool bExhausted{false};
+		TestTrue(TEXT("Has a pair"), Data.StepPlayback(Cursor, 1.f, LeftIndex, RightIndex, Fraction, bExhausted));
+		TestEqual(TEXT("Both frames are kept"), Data.NumFrames(), 2);
+		TestEqual(TEXT("Left index"), LeftIndex, 0);
+		TestEqual(TEXT("Right index"), RightIndex, 1);
+		TestEqual(TEXT("Holds on the oldest frame"), Fraction, 1.f);
+		TestTrue(TEXT("Exhausted"), bExhausted);
+	}
+
+	FActorData Single;
+	Record(Single, 1, Scratch);
+	int32 LeftIndex, RightIndex;
+	float Fraction;
+	bool bExhausted{false};
+	TestFalse(TEXT("A single frame has no pair"), Single.StepPlayback(Cursor, DeltaTime, LeftIndex, RightIndex, Fraction, bExhausted));
+	TestTrue(TEXT("A single frame is exhausted"), bExhausted);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FRewindHistoryFindBracketTest, "Rewind.History.FindBracket", EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FRewindHistoryFindBracketTest::RunTest(const FString& Parameters)
+{
+	using namespace RewindHistoryTests;
+
+	FRewindScratch Scratch;
+	FActorData Data;
+	Record(Data, 10, Scratch);
+
+	int32 LeftIndex, RightIndex;
+	float Fraction;
+	TestTrue(TEXT("Finds a time between frames"), Data.FindBracket(3.25 * DeltaTime, LeftIndex, RightIndex, Fraction));
+	TestEqual(TEXT("Left index"), LeftIndex, 3);
+	TestEqual(TEXT("Right index"), RightIndex, 4);
+	TestTrue(TEXT("Fraction from the right frame"), FMath::IsNearlyEqual(Fraction, 0.75f, 0.001f));
+
+	TestTrue(TEXT("Finds a time on a frame"), Data.FindBracket(5.0 * DeltaTime, LeftIndex, RightIndex, Fraction));
+	TestTrue(TEXT("Lands on that frame"), (RightIndex == 5 && FMath::IsNearlyZero(Fraction, 0.001f)) || (LeftIndex == 5 && FMath::IsNearlyEqual(Fraction, 1.f, 0.001f)));
+
+	TestTrue(TEXT("Clamps before the oldest frame"), Data.FindBracket(-1.0, LeftIndex, RightIndex, Fraction));
+	TestTrue(TEXT("On the oldest frame"), LeftIndex == 0 && FMath::IsNearlyEqual(Fraction, 1.f));
+
+	TestTrue(TEXT("Clamps after the newest frame"), Data.FindBracket(1.0, LeftIndex, RightIndex, Fraction));
+	TestTrue(TEXT("On the newest frame"), RightIndex == 9 && FMath::IsNearlyZero(Fraction));
+
+	FActorData Single;
+	Record(Single, 1, Scratch);
+	TestFalse(TEXT("A single frame has no bracket"), Single.FindBracket(0.0, LeftIndex, RightIndex, Fraction));
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FRewindHistoryThinFramesTest, "Rewind.History.ThinFrames", EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FRewindHistoryThinFramesTest::RunTest(const FString& Parameters)
+{
+	using namespace RewindHistoryTests;
+
+	FRewindScratch Scratch;
+
+	for (const auto Compression : {ERewindFrameCompression::None, ERewindFrameCompression::Quantized})
+	{
+		const TCHAR* Name{CompressionName(Compression)};
+		FActorData Data;
+		Data.SetCompression(Compression, 0.01f);
+		Record(Data, 30, Scratch);
+
+		const float RecordedTime{Data.GetRecordedTime()};
+		const double Cutoff{MakeFrame(20).Timestamp};
+		const float MaxInterval{DeltaTime * 2.5f};
+		const int32 Removed{Data.ThinFrames(Cutoff, MaxInterval)};
+
+		TestTrue(FString::Printf(TEXT("%s drops old frames"), Name), Removed > 0);
+		TestEqual(FString::Printf(TEXT("%s reports what it dropped"), Name), Data.NumFrames(), 30 - Removed);
+		TestTrue(FString::Printf(TEXT("%s keeps the recorded time"), Name), FMath::IsNearlyEqual(Data.GetRecordedTime(), RecordedTime, UE_KINDA_SMALL_NUMBER));
+		TestEqual(FString::Printf(TEXT("%s keeps the newest frame"), Name), Data.GetFrameTimestamp(Data.NumFrames() - 1), MakeFrame(29).Timestamp);
+
+		// Every frame still spans exactly the time since the one before it.
+		for (int32 Index = 1; Index < Data.NumFrames(); ++Index)
+		{
+			const double Span{Data.GetFrameTimestamp(Index) - Data.GetFrameTimestamp(Index - 1)};
+			if (!TestTrue(FString::Printf(TEXT("%s frame %d spans its gap"), Name, Index), FMath::IsNearlyEqual(Span, static_cast<double>(Data.GetFrameDeltaTime(Index)), 0.0001)
+				&& Data.GetFrameDeltaTime(Index) <= MaxInterval + UE_KINDA_SMALL_NUMBER))
+			{
+				break;
+			}
+		}
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FRewindHistoryPoseScaleTest, "Rewind.History.PoseScale", EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FRewindHistoryPoseScaleTest::RunTest(const FString& Parameters)
+{
+	using namespace RewindHistoryTests;
+
+	const FRewindKeyframeReduction Reduction;
+	FRewindScratch Scratch;
+	FActorData Data;
+	Data.SetCompression(ERewindFrameCompression::Quantized, 0.01f);
+	Data.SetPoseBoneCount(2);
+
+	const TArray<FTransform> Unscaled{FTransform(FVector(0.0, 0.0, 10.0)), FTransform(FVector(0.0, 0.0, 20.0))};
+	for (int32 Index = 0; Index < 4; ++Index)
+	{
+		Data.RecordFrame(MakeFrame(Index), Unscaled, MAX_flt, Reduction, Scratch);
+	}
+	TestFalse(TEXT("No scale channel while no bone is scaled"), Data.GetFormat().bPackedPoseHasScale);
+
+	// A copy of the oldest frames in the narrow format, as a spilled chunk would hold them.
+	const FRewindHistoryFormat NarrowFormat{Data.GetFormat()};
+	TArray<uint8> NarrowBytes;
+	Data.WriteHeadFrames(2, NarrowBytes);
+	Data.PopHeadFrame();
+	Data.PopHeadFrame();
+
+	TArray<FTransform> Scaled{Unscaled};
+	Scaled[1].SetScale3D(FVector(2.0));
+	Data.RecordFrame(MakeFrame(4), Scaled, MAX_flt, Reduction, Scratch);
+
+	TestTrue(TEXT("A scaled bone widens the poses"), Data.GetFormat().bPackedPoseHasScale);
+	TestEqual(TEXT("Frames recorded before are kept"), Data.NumFrames(), 3);
+	TestTrue(TEXT("Earlier poses get a unit scale"), Data.GetPose(0, Scratch.Poses[0])[1].GetScale3D().Equals(FVector::OneVector, 0.001));
+	TestTrue(TEXT("Earlier poses keep their translation"), Data.GetPose(0, Scratch.Poses[0])[1].GetTranslation().Equals(Unscaled[1].GetTranslation(), 0.02));
+	TestTrue(TEXT("The new pose keeps its scale"), Data.GetPose(2, Scratch.Poses[0])[1].GetScale3D().Equals(FVector(2.0), 0.01));
+
+	TestTrue(TEXT("Narrow frames are widened when put back"), Data.PrependFrames(NarrowFormat, NarrowBytes, 2));
+	TestEqual(TEXT("Every frame is back"), Data.NumFrames(), 5);
+	TestEqual(TEXT("Oldest frame first"), Data.GetFrameTimestamp(0), MakeFrame(0).Timestamp);
+	TestTrue(TEXT("Put back poses get a unit scale"), Data.GetPose(0, Scratch.Poses[0])[1].GetScale3D().Equals(FVector::OneVector, 0.001));
+	return true;
+}
+#endif
@@ -0,0 +1,37 @@
+﻿#include "RewindPoseBlend.h"
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_AUTOMATION_TESTS
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FRewindPoseBlendSlerpTest, "Rewind.PoseBlend.MatchesSlerp", EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FRewindPoseBlendSlerpTest::RunTest(const FString& Parameters)
+{
+	// One bone per turn from a degree to nearly opposite, about an axis that isn't aligned with anything.
+	const FVector Axis{FVector(1.0, 2.0, 3.0).GetSafeNormal()};
+	TArray<FTransform> From, To;
+	for (int32 Degrees = 1; Degrees < 180; ++Degrees)
+	{
+		const FQuat Rotation{FRotator(10.0, Degrees, -20.0)};
+		From.Emplace(Rotation);
+		To.Emplace(FQuat(Axis, FMath::DegreesToRadians(static_cast<double>(Degrees))) * Rotation);
+	}
+
+	TArray<FTransform> Blended;
+	Blended.SetNum(From.Num());
+	for (const float Alpha : {0.f, 0.1f, 0.25f, 0.5f, 0.75f, 0.9f, 1.f})
+	{
+		RewindPoseBlend::BlendPoses(From, To, Alpha, Blended);
+		for (int32 BoneIndex = 0; BoneIndex < Blended.Num(); ++BoneIndex)
+		{
+			const FQuat Slerp{FQuat::Slerp(From[BoneIndex].GetRotation(), To[BoneIndex].GetRotation(), Alpha)};
+			const double Error{FMath::RadiansToDegrees(Slerp.AngularDistance(Blended[BoneIndex].GetRotation()))};
+			if (!TestTrue(FString::Printf(TEXT("Turn of %d degrees at %.2f is within 0.05 degrees of a slerp (%f)"), BoneIndex + 1, Alpha, Error), Error <= 0.05))
+			{
+				return true;
+			}
+		}
+	}
+	return true;
+}
+#endif
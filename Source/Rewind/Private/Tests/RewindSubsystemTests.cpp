@@ -0,0 +1,197 @@
+﻿#include "RewindSubsystem.h"
+
+#include "RewindComponent.h"
+#include "RewindDeveloperSettings.h"
+#include "Components/StaticMeshComponent.h"
+#include "Engine/Engine.h"
+#include "Engine/StaticMeshActor.h"
+#include "Engine/World.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_AUTOMATION_TESTS
+namespace RewindSubsystemTests
+{
+	static constexpr float DeltaTime{1.f / 60.f};
+	static constexpr double Step{10.0};
+
+	//Game world of its own, ticked by hand so nothing else moves the actors
+	struct FTestWorld
+	{
+		FTestWorld()
+		{
+			World = UWorld::CreateWorld(EWorldType::Game, false);
+			GEngine->CreateNewWorldContext(EWorldType::Game).SetCurrentWorld(World);
+			World->InitializeActorsForPlay(FURL());
+			World->BeginPlay();
+			Subsystem = World->GetSubsystem<URewindSubsystem>();
+		}
+
+		~FTestWorld()
+		{
+			GEngine->DestroyWorldContext(World);
+			World->DestroyWorld(false);
+		}
+
+		//Movable actor with its own rewind component, registered through its BeginPlay
+		AActor* SpawnActor(const FVector& Location) const
+		{
+			FActorSpawnParameters SpawnParameters;
+			SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+			auto* Actor{World->SpawnActor<AStaticMeshActor>(Location, FRotator::ZeroRotator, SpawnParameters)};
+			Actor->GetStaticMeshComponent()->SetMobility(EComponentMobility::Movable);
+
+			auto* Component{NewObject<URewindComponent>(Actor)};
+			Component->bAlwaysFullFidelity = true;
+			Component->RegisterComponent();
+			return Actor;
+		}
+
+		//Moves the actors Step along X, then ticks the subsystem, NumTicks times
+		void Record(TConstArrayView<AActor*> Moving, int32 NumTicks) const
+		{
+			for (int32 Tick = 0; Tick < NumTicks; ++Tick)
+			{
+				for (AActor* Actor : Moving)
+				{
+					Actor->SetActorLocation(Actor->GetActorLocation() + FVector(Step, 0.0, 0.0));
+				}
+				Subsystem->Tick(DeltaTime);
+			}
+		}
+
+		//StartReverse and EndReverse are only exposed to Blueprints, so they are called the way Blueprints call them
+		void CallFunction(const TCHAR* Name) const
+		{
+			Subsystem->ProcessEvent(Subsystem->FindFunctionChecked(Name), nullptr);
+		}
+
+		UWorld* World{nullptr};
+		URewindSubsystem* Subsystem{nullptr};
+	};
+
+	//Overrides one of the rewind settings for the length of a test
+	template <typename PropertyType, typename ValueType>
+	class TScopedSetting
+	{
+	public:
+		TScopedSetting(FName Name, ValueType Value)
+			: Property(FindFProperty<PropertyType>(URewindDeveloperSettings::StaticClass(), Name))
+			, Settings(GetMutableDefault<URewindDeveloperSettings>())
+		{
+			check(Property);
+			Saved = Property->GetPropertyValue_InContainer(Settings);
+			Set(Value);
+		}
+
+		~TScopedSetting()
+		{
+			Set(Saved);
+		}
+
+		void Set(ValueType Value) const
+		{
+			Property->SetPropertyValue_InContainer(Settings, Value);
+		}
+
+	private:
+		PropertyType* Property;
+		URewindDeveloperSettings* Settings;
+		ValueType Saved;
+	};
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FRewindSubsystemGroupReverseTest, "Rewind.Subsystem.GroupReverse", EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FRewindSubsystemGroupReverseTest::RunTest(const FString& Parameters)
+{
+	using namespace RewindSubsystemTests;
+
+	const TScopedSetting<FFloatProperty, float> RecordTime{TEXT("RecordTime"), 15.f};
+	const TScopedSetting<FBoolProperty, bool> Spill{TEXT("bSpillHistoryToDisk"), false};
+	FTestWorld TestWorld;
+	if (!TestNotNull(TEXT("Game worlds get the subsystem"), TestWorld.Subsystem)) return false;
+	URewindSubsystem& Subsystem{*TestWorld.Subsystem};
+
+	AActor* Rewound{TestWorld.SpawnActor(FVector(0.0, 0.0, 0.0))};
+	AActor* Recording{TestWorld.SpawnActor(FVector(0.0, 1000.0, 0.0))};
+	TestWorld.Record({Rewound, Recording}, 60);
+
+	const FRewindConfig Config{1.f, 15.f};
+	TestEqual(TEXT("The group takes its one actor"), Subsystem.StartGroupReverse(TEXT("Group"), {Rewound}, Config), 1);
+	TestTrue(TEXT("The group is reversing"), Subsystem.IsGroupReversing(TEXT("Group")));
+	TestFalse(TEXT("The rest of the world is not"), Subsystem.IsReversing());
+	TestEqual(TEXT("Group names are unique"), Subsystem.StartGroupReverse(TEXT("Group"), {Recording}, Config), 0);
+
+	// Half a second back at speed 1 takes the rewound actor from 600 back to about 300, the other keeps going.
+	const int64 RecordingBytes{Subsystem.GetActorHistoryMemoryBytes(Recording)};
+	const int64 RewoundBytes{Subsystem.GetActorHistoryMemoryBytes(Rewound)};
+	TestWorld.Record({Recording}, 30);
+	TestTrue(TEXT("The group's actor went back"), FMath::IsNearlyEqual(Rewound->GetActorLocation().X, 300.0, 3.0 * Step));
+	TestEqual(TEXT("The other actor is left where it was put"), Recording->GetActorLocation().X, 90.0 * Step);
+	TestTrue(TEXT("The other actor keeps recording"), Subsystem.GetActorHistoryMemoryBytes(Recording) > RecordingBytes);
+	TestTrue(TEXT("The group's actor plays its history back"), Subsystem.GetActorHistoryMemoryBytes(Rewound) < RewoundBytes);
+
+	Subsystem.EndGroupReverse(TEXT("Group"));
+	TestFalse(TEXT("The group ended"), Subsystem.IsGroupReversing(TEXT("Group")));
+	const int64 EndedBytes{Subsystem.GetActorHistoryMemoryBytes(Rewound)};
+	TestWorld.Record({Rewound, Recording}, 10);
+	TestTrue(TEXT("The group's actor records again"), Subsystem.GetActorHistoryMemoryBytes(Rewound) > EndedBytes);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FRewindSubsystemMemoryBudgetTest, "Rewind.Subsystem.MemoryBudget", EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FRewindSubsystemMemoryBudgetTest::RunTest(const FString& Parameters)
+{
+	using namespace RewindSubsystemTests;
+
+	const TScopedSetting<FFloatProperty, float> RecordTime{TEXT("RecordTime"), 15.f};
+	const TScopedSetting<FBoolProperty, bool> Spill{TEXT("bSpillHistoryToDisk"), false};
+	const TScopedSetting<FIntProperty, int32> MaxBranches{TEXT("MaxTimelineBranches"), 1};
+	const TScopedSetting<FInt64Property, int64> Budget{TEXT("HistoryMemoryBudgetBytes"), 0};
+	FTestWorld TestWorld;
+	if (!TestNotNull(TEXT("Game worlds get the subsystem"), TestWorld.Subsystem)) return false;
+	URewindSubsystem& Subsystem{*TestWorld.Subsystem};
+
+	TArray<AActor*> Actors;
+	for (int32 Index = 0; Index < 4; ++Index)
+	{
+		Actors.Add(TestWorld.SpawnActor(FVector(0.0, Index * 1000.0, 0.0)));
+	}
+	const auto GetLiveBytes = [&Subsystem, &Actors]()
+	{
+		int64 Bytes{0};
+		for (AActor* Actor : Actors)
+		{
+			Bytes += Subsystem.GetActorHistoryMemoryBytes(Actor);
+		}
+		return Bytes;
+	};
+
+	// Going back a second and recording again forks that second off into a branch.
+	TestWorld.Record(Actors, 120);
+	TestWorld.CallFunction(TEXT("StartReverse"));
+	for (int32 Tick = 0; Tick < 60; ++Tick)
+	{
+		Subsystem.Tick(DeltaTime);
+	}
+	TestWorld.CallFunction(TEXT("EndReverse"));
+	TestWorld.Record(Actors, 10);
+	if (!TestEqual(TEXT("The rewind left a branch"), Subsystem.GetBranchIds().Num(), 1)) return false;
+	TestTrue(TEXT("Branches count against the budget"), Subsystem.GetHistoryMemoryBytes() > GetLiveBytes());
+
+	// Just over budget, dropping the branch is enough and the live history stays whole.
+	const int64 LiveBytes{GetLiveBytes()};
+	Budget.Set(Subsystem.GetHistoryMemoryBytes() - 1);
+	TestWorld.Record(Actors, 1);
+	TestTrue(TEXT("The branch went first"), Subsystem.GetBranchIds().IsEmpty());
+	TestTrue(TEXT("The live history is not thinned"), GetLiveBytes() > LiveBytes);
+
+	// Well over budget, the live history has to give.
+	const int64 HalfBudget{GetLiveBytes() / 2};
+	Budget.Set(HalfBudget);
+	TestWorld.Record(Actors, 1);
+	TestTrue(TEXT("Back under budget"), Subsystem.GetHistoryMemoryBytes() <= HalfBudget);
+	return true;
+}
+#endif
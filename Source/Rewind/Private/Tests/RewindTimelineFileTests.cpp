@@ -0,0 +1,129 @@
+﻿#include "RewindTimelineFile.h"
+
+#include "Misc/AutomationTest.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+#include <limits>
+
+#if WITH_AUTOMATION_TESTS
+namespace RewindTimelineFileTests
+{
+	static constexpr float DeltaTime{1.f / 60.f};
+
+	//Header and payload of one actor's NumFrames frames, written the way SaveTimeline does
+	static FRewindTimelineHeader MakeTimeline(ERewindFrameCompression Compression, int32 NumFrames, TArray<uint8>& OutPayload)
+	{
+		FActorData Data;
+		Data.SetCompression(Compression, 0.01f);
+		const FRewindKeyframeReduction Reduction;
+		FRewindScratch Scratch;
+		for (int32 Index = 0; Index < NumFrames; ++Index)
+		{
+			FActorFrameSnapshot Frame{FVector(Index * 10.0, 0.0, 0.0), FRotator(0.0, Index, 0.0), FVector(600.0, 0.0, 0.0), FVector::ZeroVector, DeltaTime};
+			Frame.Timestamp = Index * static_cast<double>(DeltaTime);
+			Data.RecordFrame(Frame, {}, MAX_flt, Reduction, Scratch);
+		}
+
+		auto Header{RewindTimelineFile::MakeHeader()};
+		Header.RecordingClock = (NumFrames - 1) * static_cast<double>(DeltaTime);
+		auto& Entry = Header.Actors.AddDefaulted_GetRef();
+		Entry.ActorPath = TEXT("/Game/Test.Test:PersistentLevel.Actor");
+		Entry.Format = Data.GetFormat();
+		Entry.NumFrames = Data.NumFrames();
+		Entry.Size = Data.NumFrames() * Data.GetFrameBytes();
+		Data.WriteHeadFrames(Data.NumFrames(), OutPayload);
+		return Header;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FRewindTimelineFileRoundTripTest, "Rewind.TimelineFile.RoundTrip", EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FRewindTimelineFileRoundTripTest::RunTest(const FString& Parameters)
+{
+	using namespace RewindTimelineFileTests;
+
+	for (const auto Compression : {ERewindFrameCompression::None, ERewindFrameCompression::Quantized})
+	{
+		const TCHAR* Name{Compression == ERewindFrameCompression::None ? TEXT("uncompressed") : TEXT("quantized")};
+		TArray<uint8> Payload;
+		auto Saved{MakeTimeline(Compression, 30, Payload)};
+
+		TArray<uint8> Bytes;
+		FMemoryWriter Writer{Bytes};
+		RewindTimelineFile::SerializeHeader(Writer, Saved);
+		const int64 PayloadStart{Bytes.Num()};
+		Bytes.Append(Payload);
+
+		FRewindTimelineHeader Loaded;
+		FMemoryReader Reader{Bytes};
+		RewindTimelineFile::SerializeHeader(Reader, Loaded);
+		if (!TestFalse(FString::Printf(TEXT("%s header reads back"), Name), Reader.IsError())) continue;
+		TestEqual(FString::Printf(TEXT("%s header ends where it was written"), Name), Reader.Tell(), PayloadStart);
+		TestTrue(FString::Printf(TEXT("%s header is valid"), Name), RewindTimelineFile::IsValid(Loaded, Bytes.Num() - PayloadStart));
+		if (!TestEqual(FString::Printf(TEXT("%s actor count"), Name), Loaded.Actors.Num(), 1)) continue;
+
+		const auto& Entry = Loaded.Actors[0];
+		TestEqual(FString::Printf(TEXT("%s actor path"), Name), Entry.ActorPath, Saved.Actors[0].ActorPath);
+		TestTrue(FString::Printf(TEXT("%s format"), Name), Entry.Format == Saved.Actors[0].Format);
+
+		FActorData Restored;
+		const TConstArrayView<uint8> Frames{Bytes.GetData() + PayloadStart + Entry.Offset, static_cast<int32>(Entry.Size)};
+		if (!TestTrue(FString::Printf(TEXT("%s frames restore"), Name), Restored.RestoreFrames(Entry.Format, Frames, Entry.NumFrames))) continue;
+		TestEqual(FString::Printf(TEXT("%s frame count"), Name), Restored.NumFrames(), 30);
+
+		FActorFrameSnapshot Scratch;
+		for (int32 Index = 0; Index < Restored.NumFrames(); ++Index)
+		{
+			const FActorFrameSnapshot& Frame{Restored.GetFrame(Index, Scratch)};
+			if (!TestTrue(FString::Printf(TEXT("%s frame %d location"), Name, Index), Frame.Location.Equals(FVector(Index * 10.0, 0.0, 0.0), 0.02))) break;
+		}
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FRewindTimelineFileRejectsCorruptTest, "Rewind.TimelineFile.RejectsCorrupt", EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FRewindTimelineFileRejectsCorruptTest::RunTest(const FString& Parameters)
+{
+	using namespace RewindTimelineFileTests;
+
+	TArray<uint8> Payload;
+	const auto Valid{MakeTimeline(ERewindFrameCompression::Quantized, 10, Payload)};
+	TestTrue(TEXT("Untouched header is valid"), RewindTimelineFile::IsValid(Valid, Payload.Num()));
+
+	const auto TestRejects = [this, &Valid, &Payload](const TCHAR* What, TFunctionRef<void(FRewindTimelineHeader&)> Corrupt)
+	{
+		auto Header{Valid};
+		Corrupt(Header);
+		TestFalse(What, RewindTimelineFile::IsValid(Header, Payload.Num()));
+	};
+	TestRejects(TEXT("Frames past the payload"), [](FRewindTimelineHeader& Header) { Header.Actors[0].Offset = 1; });
+	TestRejects(TEXT("Negative offset"), [](FRewindTimelineHeader& Header) { Header.Actors[0].Offset = -1; });
+	TestRejects(TEXT("Size that doesn't match the frames"), [](FRewindTimelineHeader& Header) { --Header.Actors[0].Size; });
+	TestRejects(TEXT("More frames than the payload holds"), [](FRewindTimelineHeader& Header) { Header.Actors[0].NumFrames = MAX_int32; });
+	TestRejects(TEXT("Negative frame count"), [](FRewindTimelineHeader& Header) { Header.Actors[0].NumFrames = -1; });
+	TestRejects(TEXT("Unknown compression"), [](FRewindTimelineHeader& Header) { Header.Actors[0].Format.Compression = static_cast<ERewindFrameCompression>(7); });
+	TestRejects(TEXT("NaN quantization error"), [](FRewindTimelineHeader& Header) { Header.Actors[0].Format.MaxQuantizationError = std::numeric_limits<float>::quiet_NaN(); });
+	TestRejects(TEXT("Pose layout outside the table"), [](FRewindTimelineHeader& Header) { Header.Actors[0].PoseLayoutId = 3; });
+	TestRejects(TEXT("Bone count that isn't the layout's"), [](FRewindTimelineHeader& Header) { Header.Actors[0].Format.PoseBoneCount = 2; });
+	TestRejects(TEXT("Layout with mismatched parents"), [](FRewindTimelineHeader& Header)
+	{
+		auto& Layout = Header.Layouts.AddDefaulted_GetRef();
+		Layout.BoneNames = {TEXT("root"), TEXT("pelvis")};
+		Layout.ParentIndices = {INDEX_NONE};
+	});
+
+	// A header from another build layout is refused before anything else is read.
+	auto Foreign{Valid};
+	++Foreign.FrameSize;
+	TArray<uint8> Bytes;
+	FMemoryWriter Writer{Bytes};
+	RewindTimelineFile::SerializeHeader(Writer, Foreign);
+	FRewindTimelineHeader Loaded;
+	FMemoryReader Reader{Bytes};
+	RewindTimelineFile::SerializeHeader(Reader, Loaded);
+	TestTrue(TEXT("Other frame layouts fail to read"), Reader.IsError());
+	return true;
+}
+#endif
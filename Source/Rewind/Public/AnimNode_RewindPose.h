@@ -0,0 +1,38 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "Animation/AnimNodeBase.h"
+#include "AnimNode_RewindPose.generated.h"
+
+class URewindComponent;
+
+/**
+ * Outputs the owner's rewound pose while it reverses time, and Source otherwise.
+ *
+ * The pose is read straight from the rewind component's front buffer, which the subsystem only writes again after
+ * publishing its next pose to the other one, so evaluation needs neither a copy nor a lock.
+ */
+USTRUCT(BlueprintInternalUseOnly)
+struct REWIND_API FAnimNode_RewindPose : public FAnimNode_Base
+{
+	GENERATED_BODY()
+
+	//Pose used while the owner isn't reversing time
+	UPROPERTY(EditAnywhere, Category=Links)
+	FPoseLink Source;
+
+	// FAnimNode_Base interface
+	virtual void Initialize_AnyThread(const FAnimationInitializeContext& Context) override;
+	virtual void CacheBones_AnyThread(const FAnimationCacheBonesContext& Context) override;
+	virtual void Update_AnyThread(const FAnimationUpdateContext& Context) override;
+	virtual void Evaluate_AnyThread(FPoseContext& Output) override;
+	virtual void GatherDebugData(FNodeDebugData& DebugData) override;
+	virtual bool HasPreUpdate() const override { return true; }
+	virtual void PreUpdate(const UAnimInstance* InAnimInstance) override;
+	// End of FAnimNode_Base interface
+
+private:
+	TWeakObjectPtr<const URewindComponent> RewindComponent;
+	//Front pose picked on the game thread for this update, null while not reversing
+	const FPoseSnapshot* RewindPose{nullptr};
+};
@@ -0,0 +1,118 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "RewindBodyHistory.h"
+#include "RewindHistoryIndex.h"
+#include "RewindSpillTimeline.h"
+#include "RewindTypes.h"
+
+class ACharacter;
+class FReferenceCollector;
+class UPrimitiveComponent;
+class URewindComponent;
+class USkeletalMeshComponent;
+
+enum class ERewindActorKind : uint8
+{
+	//Root is a primitive component, its physics velocities are recorded and restored
+	Primitive,
+	//Movement velocity and animation pose are recorded
+	Character,
+	//Transform only
+	Other
+};
+
+//How closely an actor is recorded, picked by the significance pass
+enum class ERewindRecordingLOD : uint8
+{
+	//Every recording step, with poses, over the whole window
+	Full,
+	//At the reduced sample rate, with poses
+	Reduced,
+	//At the minimal sample rate, root motion only, over the minimal window
+	Minimal
+};
+
+/**
+ * Dense structure-of-arrays storage of every actor registered for rewind.
+ *
+ * An actor gets a slot when it is added. Its kind and the components recording and playback need are resolved at
+ * that point and refreshed before each recording pass, and the scalars touched every tick live in contiguous arrays
+ * indexed by slot. Removal swaps the last slot into the hole, so a slot is stable until the next removal.
+ *
+ * A uniform grid over the actors' locations finds the slots in a region without walking them all. It is as current as
+ * the last UpdateGridLocation of each slot.
+ */
+class REWIND_API FRewindActorRegistry
+{
+public:
+	int32 Num() const { return Actors.Num(); }
+	bool IsEmpty() const { return Actors.IsEmpty(); }
+
+	//Returns the actor's slot, adding it if needed
+	int32 Add(AActor* InActor, URewindComponent* InComponent);
+	int32 Find(TObjectKey<AActor> InActor) const;
+	//Keys of the actors, by slot
+	TConstArrayView<TObjectKey<AActor>> GetActorKeys() const { return ActorKeys; }
+	void RemoveAtSwap(int32 Slot);
+
+	//Re-resolves the slot's kind and components if the owner destroyed or replaced them since the last call
+	void RefreshComponents(int32 Slot);
+	//Reports the cached components to the garbage collector, which clears them once destroyed
+	void AddReferencedObjects(FReferenceCollector& Collector);
+
+	//Changing the cell size, in cm, rebuilds the grid from the actors' current locations
+	void SetGridCellSize(float InCellSize);
+	//Moves the slot to the cell of Location if it left its own
+	void UpdateGridLocation(int32 Slot, const FVector& Location);
+	//Appends the slots whose cell Box overlaps. Callers test the exact locations.
+	void GatherGridSlots(const FBox& Box, TArray<int32>& OutSlots) const;
+
+	//The actor and its own rewind component, which removes it again in EndPlay, so these never outlive it
+	TArray<AActor*> Actors;
+	TArray<URewindComponent*> Components;
+	TArray<ACharacter*> Characters;
+	//Components the owner can destroy or swap while it plays, kept current by RefreshComponents
+	TArray<ERewindActorKind> Kinds;
+	TArray<TObjectPtr<UPrimitiveComponent>> RootPrimitives;
+	TArray<TObjectPtr<USkeletalMeshComponent>> Meshes;
+	//Mesh whose physics bodies are recorded, null unless the component asks for it
+	TArray<TObjectPtr<USkeletalMeshComponent>> BodyMeshes;
+	//What history queries test against
+	TArray<FRewindHistoryShape> Shapes;
+
+	TArray<FRewindPlaybackCursor> PlaybackCursors;
+	TArray<bool> OutOfData;
+
+	TArray<ERewindRecordingLOD> RecordingLODs;
+	//Set while the actor rewinds with a group, which keeps it out of recording
+	TArray<bool> GroupRewinding;
+	//Time since the slot's last recorded frame, which the next one covers
+	TArray<float> SampleAccumulators;
+
+	//Window each history is trimmed to on top of the recorded time setting, shortened under the memory budget
+	TArray<float> RecordedTimeLimits;
+
+	TArray<FActorData> Histories;
+	//Frames playback went back past, oldest first, until replayed or forked off into a branch
+	TArray<FActorData> Futures;
+	//Older part of each history, on disk when spilling is enabled
+	TArray<FRewindSpillState> Spills;
+	TArray<FRewindBodyHistory> BodyHistories;
+	//Bodies blended by playback, written back on the game thread
+	TArray<TArray<FRewindBodyState>> BodyStates;
+	//Last frame put in the history query index
+	TArray<FRewindIndexCursor> IndexCursors;
+
+private:
+	FIntVector GetGridCell(const FVector& Location) const;
+	void AddToGrid(int32 Slot, const FIntVector& Cell);
+	void RemoveFromGrid(int32 Slot);
+
+	TArray<TObjectKey<AActor>> ActorKeys;
+	TMap<TObjectKey<AActor>, int32> SlotByActor;
+
+	float GridCellSize{2000.f};
+	TArray<FIntVector> GridCells;
+	TMap<FIntVector, TArray<int32>> Grid;
+};
@@ -0,0 +1,54 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "RewindFrameStore.h"
+
+//One simulated body in world space
+struct FRewindBodyState
+{
+	FVector Location{FVector::ZeroVector};
+	FQuat Rotation{FQuat::Identity};
+	FVector LinearVelocity{FVector::ZeroVector};
+	//In radians per second
+	FVector AngularVelocity{FVector::ZeroVector};
+};
+
+struct FRewindBodyFrame
+{
+	//Recording clock at capture, in seconds. Matches the timestamp of the actor's frame recorded in the same step.
+	double Timestamp{0.0};
+};
+
+/**
+ * Every body of a skeletal mesh's physics asset, recorded next to the actor's history.
+ *
+ * A frame is one packed block of body states in the frame store's pool, in the order of the mesh's body instances.
+ * Frames are matched to the actor's history by timestamp rather than index, so keyframe reduction, thinning and
+ * spilling of the main history leave them alone. Body frames live in memory only and are not saved with timelines.
+ */
+class REWIND_API FRewindBodyHistory
+{
+public:
+	int32 NumFrames() const { return Frames.Num(); }
+	bool HasFrames() const { return !Frames.IsEmpty(); }
+	int32 GetNumBodies() const { return Frames.GetPoseStride(); }
+	int64 GetMemoryBytes() const { return Frames.Num() * Frames.GetFrameBytes(); }
+
+	//Changing the body count drops the recorded frames
+	void SetNumBodies(int32 InNumBodies) { Frames.SetPoseStride(InNumBodies); }
+	void Reserve(int32 InCapacity) { Frames.Reserve(InCapacity); }
+	void Reset() { Frames.Reset(); }
+
+	//Pops the frames older than MaxRecordedTime before Timestamp and returns the body states of a new frame to fill
+	TArrayView<FRewindBodyState> AddFrame(double Timestamp, float MaxRecordedTime);
+	//Pops the frames after Timestamp, for history that playback consumed
+	void TrimTail(double Timestamp);
+	//Pops the frames before Timestamp, for history the actor's own history no longer reaches back to
+	void TrimHead(double Timestamp);
+
+	//Blends the bodies at Time into Out, GetNumBodies() states. Fails if Time is older than the oldest frame.
+	bool Sample(double Time, TArrayView<FRewindBodyState> Out) const;
+
+private:
+	TRewindFrameStore<FRewindBodyFrame, FRewindBodyState> Frames;
+};
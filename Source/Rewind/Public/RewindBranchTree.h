@@ -0,0 +1,44 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "RewindTypes.h"
+
+/**
+ * Timelines the live one forked from or was switched away from, as a tree rooted at the live timeline.
+ *
+ * A branch holds only the frames its timeline recorded after its fork point. Up to that point it is whatever its parent
+ * timeline holds there, the live histories for a branch forked off the live timeline. A branch's children always forked
+ * after it did. Switching walks the path from the live timeline to the branch one fork at a time, trading only the
+ * frames after each fork point, so forks of forks come back exactly as they were left.
+ */
+class REWIND_API FRewindBranchTree
+{
+public:
+	//Oldest first
+	const TArray<FRewindBranch>& GetBranches() const { return Branches; }
+	int32 GetCurrentId() const { return CurrentId; }
+	int64 GetMemoryBytes() const;
+	void Reset();
+
+	//Moves each actor's frames playback went back past, which are newer than ForkTimestamp, into a branch of the current
+	//timeline and goes on under a new id. Costs no copy, the futures are handed over as they are. Keeps at most
+	//MaxBranches branches, dropping the oldest, and none of the futures without any.
+	void Fork(double ForkTimestamp, TConstArrayView<TObjectKey<AActor>> Actors, TArrayView<FActorData> Futures, int32 MaxBranches);
+
+	//Rebuilds the branch's timeline in the actors' histories and keeps the one it replaces as a branch in turn.
+	//OutForkTimestamp is the earliest point after which the histories changed. Fails for an unknown id.
+	bool SwitchTo(int32 BranchId, TConstArrayView<TObjectKey<AActor>> Actors, TArrayView<FActorData> Histories, double& OutForkTimestamp);
+
+	//Drops the oldest branch and every branch forked off it. Returns false if there are none.
+	bool RemoveOldest();
+
+private:
+	//Trades the frames after the fork of a branch whose parent is the live timeline. Returns its fork timestamp.
+	double SwitchToChild(int32 BranchIndex, TConstArrayView<TObjectKey<AActor>> Actors, TArrayView<FActorData> Histories);
+	void RemoveWithDescendants(int32 BranchId);
+	int32 FindIndex(int32 BranchId) const;
+
+	TArray<FRewindBranch> Branches;
+	int32 CurrentId{0};
+	int32 NextId{1};
+};
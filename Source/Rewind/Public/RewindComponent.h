@@ -4,8 +4,36 @@
 
 #include "CoreMinimal.h"
 #include "Components/ActorComponent.h"
+#include "RewindCompression.h"
+#include "Animation/PoseSnapshot.h"
+#include <atomic>
 #include "RewindComponent.generated.h"
 
+//Drops frames that playback can rebuild from their neighbours within these tolerances
+USTRUCT(BlueprintType)
+struct FRewindKeyframeReduction
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="TimeSync|Rewind")
+	bool bEnabled{false};
+	//Max location error of a dropped frame (root and bones), in cm
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="TimeSync|Rewind", meta=(ClampMin="0"))
+	float PositionTolerance{0.5f};
+	//Max rotation error of a dropped frame (root and bones), in degrees
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="TimeSync|Rewind", meta=(ClampMin="0"))
+	float RotationTolerance{0.5f};
+	//Max linear velocity error of a dropped frame, in cm/s
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="TimeSync|Rewind", meta=(ClampMin="0"))
+	float LinearVelocityTolerance{5.f};
+	//Max angular velocity error of a dropped frame, in rad/s
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="TimeSync|Rewind", meta=(ClampMin="0"))
+	float AngularVelocityTolerance{0.05f};
+	//Longest span a single kept frame may cover, in seconds
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="TimeSync|Rewind", meta=(ClampMin="0.01"))
+	float MaxKeyframeInterval{1.f};
+};
+
 
 UCLASS(ClassGroup=(Custom), meta=(BlueprintSpawnableComponent))
 class REWIND_API URewindComponent : public UActorComponent
@@ -27,16 +55,61 @@ public:
 	UFUNCTION(BlueprintCallable,BlueprintPure,meta=(BlueprintThreadSafe))
 	bool IsReversingTime() const;
 	
+	//Copies the rewound pose out. The Rewind Pose anim graph node reads it in place instead.
 	UFUNCTION(BlueprintCallable,BlueprintPure,meta=(BlueprintThreadSafe))
 	FPoseSnapshot TryGetPose();
+
+	//Latest rewound pose, safe to read from any thread until the subsystem's next tick publishes a newer one
+	const FPoseSnapshot& GetPose_AnyThread() const;
+
+	//Stores this actor's history quantized. Roughly 8x smaller for characters, at the cost of decoding during rewind.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="TimeSync|Rewind")
+	ERewindFrameCompression FrameCompression{ERewindFrameCompression::None};
+
+	//Largest location and bone translation error allowed by the quantized format, in cm
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="TimeSync|Rewind", meta=(ClampMin="0.001", EditCondition="FrameCompression==ERewindFrameCompression::Quantized"))
+	float MaxQuantizationError{0.01f};
+
+	//Stop storing frames of sleeping, static or linearly moving actors. Kept frames stretch their DeltaTime over the dropped ones.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="TimeSync|Rewind")
+	FRewindKeyframeReduction KeyframeReduction;
+
+	//Over the history memory budget, actors with a lower priority have their window shortened first. The highest priority present is never shortened.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="TimeSync|Rewind")
+	int32 HistoryPriority{0};
+
+	//Recorded at full rate, with poses and over the whole window, however far, hidden or over the recording budget. For the
+	//player's pawn and the like.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="TimeSync|Rewind")
+	bool bAlwaysFullFidelity{false};
+
+	//Scales the distances at which the recording LOD drops. Above 1 keeps the actor at full fidelity further away.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="TimeSync|Rewind", meta=(ClampMin="0", EditCondition="!bAlwaysFullFidelity"))
+	float SignificanceDistanceScale{1.f};
+
+	//Also records every body of the skeletal mesh's physics asset, for ragdolls and other multi-body actors. Playback
+	//restores the bodies that are simulating. Uses the character's mesh, or else the actor's first skeletal mesh component.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="TimeSync|Rewind")
+	bool bRecordPhysicsBodies{false};
 	
 protected:
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 private:
 	void AddToRewind();
 	void RemoveFromRewind();
 	
-	FPoseSnapshot TargetPose;
+	//Playback blends into the back pose in place while animation reads the front one. PublishPose swaps them.
+	FPoseSnapshot& GetBackPose();
+	int32& GetBackPoseLayoutId();
+	//Makes the back pose the front one, if anything was written to it since the last swap
+	void PublishPose();
+
+	FPoseSnapshot Poses[2];
+	//Layout whose bone names are currently in each pose, so they are only copied when it changes
+	int32 PoseLayoutIds[2]{INDEX_NONE, INDEX_NONE};
+	std::atomic<int32> FrontPose{0};
+	bool bBackPoseWritten{false};
 	
 	bool bReversingTime{false};
 	
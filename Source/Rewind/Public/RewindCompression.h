@@ -0,0 +1,65 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "Math/Float16.h"
+#include "RewindCompression.generated.h"
+
+struct FActorFrameSnapshot;
+
+UENUM(BlueprintType)
+enum class ERewindFrameCompression : uint8
+{
+	//Full precision frames
+	None,
+	//Quantized locations and bone translations, smallest-three rotations, half precision velocities
+	Quantized
+};
+
+//Compressed counterpart of FActorFrameSnapshot
+struct FPackedActorFrameSnapshot
+{
+	//Quantized relative to the actor's window origin, in steps of twice the max error
+	int32 Location[3]{};
+	//Smallest-three quaternion
+	uint16 Rotation[3]{};
+	FFloat16 LinearVelocity[3];
+	FFloat16 AngularVelocity[3];
+
+	float DeltaTime = 0.f;
+	double Timestamp = 0.0;
+	//Quantization step of the bone translations in this frame
+	float BoneTranslationStep = 0.f;
+	int32 PoseLayoutId{INDEX_NONE};
+	//bHasLinearVelocity and bHasAngularVelocity
+	uint8 VelocityFlags{0};
+};
+
+//Bone local transform as stored in the packed pose pool. Scales, when present, follow all bones as FFloat16 triplets.
+struct FPackedBoneTransform
+{
+	uint16 Rotation[3];
+	int16 Translation[3];
+};
+
+namespace RewindCompression
+{
+	//Bytes a single bone takes in the packed pose pool
+	inline int32 GetPackedBoneSize(bool bHasScale)
+	{
+		return sizeof(FPackedBoneTransform) + (bHasScale ? 3 * sizeof(FFloat16) : 0);
+	}
+
+	//48-bit smallest-three encoding, ~0.005 degrees of error
+	REWIND_API void PackQuat(const FQuat& InQuat, uint16 Out[3]);
+	REWIND_API FQuat UnpackQuat(const uint16 In[3]);
+
+	//Returns false, once the frame is encoded, if bHasScale is off and a bone carried a scale that was dropped
+	REWIND_API bool EncodeFrame(const FActorFrameSnapshot& Frame, TConstArrayView<FTransform> Pose, const FVector& Origin, float MaxError, bool bHasScale, FPackedActorFrameSnapshot& OutFrame, TArrayView<uint8> OutPose);
+
+	REWIND_API void DecodeFrame(const FPackedActorFrameSnapshot& Frame, const FVector& Origin, float MaxError, FActorFrameSnapshot& OutFrame);
+
+	REWIND_API void DecodePose(const FPackedActorFrameSnapshot& Frame, TConstArrayView<uint8> Pose, bool bHasScale, TArrayView<FTransform> OutPose);
+
+	//Copies a packed pose without a scale channel into one with a unit scale for every bone
+	REWIND_API void WidenPose(TConstArrayView<uint8> Pose, int32 NumBones, TArrayView<uint8> OutPose);
+}
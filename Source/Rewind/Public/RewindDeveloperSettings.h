@@ -18,6 +18,29 @@ class REWIND_API URewindDeveloperSettings : public UDeveloperSettings
 public:
 	float GetRewindSpeed() const;
 	float GetRecordedTimeSeconds() const;
+	float GetExpectedTickRate() const;
+	float GetSampleRate() const;
+	float GetRecordingBudgetMicroseconds() const;
+	int32 GetMaxTimelineBranches() const;
+	int64 GetHistoryMemoryBudgetBytes() const;
+	float GetMaxThinnedFrameInterval() const;
+	float GetMinShortenedRecordTime() const;
+	bool IsHistorySpillEnabled() const;
+	float GetSpillRecordTime() const;
+	float GetSpillChunkTime() const;
+	float GetSpillPrefetchTime() const;
+	int64 GetSpillSegmentBytes() const;
+	bool IsRecordingLODEnabled() const;
+	float GetSignificanceInterval() const;
+	float GetFullFidelityDistance() const;
+	float GetReducedFidelityDistance() const;
+	float GetReducedSampleRate() const;
+	float GetMinimalSampleRate() const;
+	float GetMinimalRecordTime() const;
+	bool IsHistoryIndexEnabled() const;
+	float GetHistoryIndexBucketTime() const;
+	float GetHistoryIndexCellSize() const;
+	float GetActorGridCellSize() const;
 	TSoftObjectPtr<UCurveFloat> GetRewindCurveFloat() const;
 	
 private:
@@ -25,6 +48,81 @@ private:
 	float RecordTime{15.f};
 	UPROPERTY(EditAnywhere,Config)
 	float RewindSpeed{1.f};
+	//Used to preallocate each actor's history (RecordTime * ExpectedTickRate frames). Histories still grow if the game ticks faster.
+	UPROPERTY(EditAnywhere,Config,meta=(ClampMin="1"))
+	float ExpectedTickRate{60.f};
+	//Default recording rate in Hz, independent of the tick rate. 0 records every tick.
+	UPROPERTY(EditAnywhere,Config,meta=(ClampMin="0"))
+	float SampleRate{0.f};
 	UPROPERTY(EditAnywhere,Config)
 	TSoftObjectPtr<UCurveFloat> RewindCurve;
+	//CPU time recording may take per tick, in microseconds. Over it, the actors due are recorded round-robin across ticks,
+	//their frames stretching over the ticks they waited. Always full fidelity actors are recorded every tick regardless.
+	//0 records every actor due.
+	UPROPERTY(EditAnywhere,Config,meta=(ClampMin="0"))
+	float RecordingBudgetMicroseconds{0.f};
+	//Earlier timelines kept when recording resumes in the middle of the history, each holding only its frames after the
+	//fork. The oldest goes first. 0 drops what playback went back past as soon as recording resumes.
+	UPROPERTY(EditAnywhere,Config,meta=(ClampMin="0"))
+	int32 MaxTimelineBranches{1};
+	//Cap on the memory of every recorded history together, timeline branches and physics bodies included, in bytes. Over
+	//it, branches are dropped oldest first, then old frames thinned, low priority windows shortened and the oldest frames
+	//dropped. 0 leaves RecordTime as the only limit.
+	UPROPERTY(EditAnywhere,Config,meta=(ClampMin="0"))
+	int64 HistoryMemoryBudgetBytes{0};
+	//Thinning never merges frames into one spanning more than this, in seconds
+	UPROPERTY(EditAnywhere,Config,meta=(ClampMin="0"))
+	float MaxThinnedFrameInterval{0.25f};
+	//Shortened low priority actors keep at least this much history, in seconds
+	UPROPERTY(EditAnywhere,Config,meta=(ClampMin="0"))
+	float MinShortenedRecordTime{2.f};
+	//Keeps history older than RecordTime in append-only files under Saved/Rewind, mapped back in when playback reaches it
+	UPROPERTY(EditAnywhere,Config)
+	bool bSpillHistoryToDisk{false};
+	//Whole window kept in memory and on disk together when spilling, in seconds
+	UPROPERTY(EditAnywhere,Config,meta=(ClampMin="0",EditCondition="bSpillHistoryToDisk"))
+	float SpillRecordTime{300.f};
+	//Span of the frames written to disk at once, in seconds
+	UPROPERTY(EditAnywhere,Config,meta=(ClampMin="0.1",EditCondition="bSpillHistoryToDisk"))
+	float SpillChunkTime{2.f};
+	//How much history left in memory ahead of the rewind cursor starts mapping the next chunk, in seconds
+	UPROPERTY(EditAnywhere,Config,meta=(ClampMin="0",EditCondition="bSpillHistoryToDisk"))
+	float SpillPrefetchTime{1.f};
+	//Size at which a spill file is closed and a new one started, in bytes
+	UPROPERTY(EditAnywhere,Config,meta=(ClampMin="1",EditCondition="bSpillHistoryToDisk"))
+	int64 SpillSegmentBytes{64 * 1024 * 1024};
+	//Records actors far from every player's view, or unseen, at a lower rate, without poses and over a shorter window
+	UPROPERTY(EditAnywhere,Config)
+	bool bUseRecordingLOD{false};
+	//How often the actors' significance is evaluated, in seconds
+	UPROPERTY(EditAnywhere,Config,meta=(ClampMin="0",EditCondition="bUseRecordingLOD"))
+	float SignificanceInterval{0.25f};
+	//Closer than this to a player's view point, actors are recorded at full fidelity, in cm
+	UPROPERTY(EditAnywhere,Config,meta=(ClampMin="0",EditCondition="bUseRecordingLOD"))
+	float FullFidelityDistance{3000.f};
+	//Further than this, actors are recorded at minimal fidelity, in cm. Actors not rendered lately drop one level more.
+	UPROPERTY(EditAnywhere,Config,meta=(ClampMin="0",EditCondition="bUseRecordingLOD"))
+	float ReducedFidelityDistance{10000.f};
+	//Recording rate of reduced fidelity actors, in Hz
+	UPROPERTY(EditAnywhere,Config,meta=(ClampMin="0.1",EditCondition="bUseRecordingLOD"))
+	float ReducedSampleRate{20.f};
+	//Recording rate of minimal fidelity actors, in Hz. They store root motion only.
+	UPROPERTY(EditAnywhere,Config,meta=(ClampMin="0.1",EditCondition="bUseRecordingLOD"))
+	float MinimalSampleRate{5.f};
+	//History kept by minimal fidelity actors, in seconds
+	UPROPERTY(EditAnywhere,Config,meta=(ClampMin="0",EditCondition="bUseRecordingLOD"))
+	float MinimalRecordTime{5.f};
+	//Indexes the recorded bounds by time and place so history queries only test the actors near the trace. Without it
+	//every actor is tested.
+	UPROPERTY(EditAnywhere,Config)
+	bool bIndexHistoryForQueries{false};
+	//Time slice of the history query index, in seconds
+	UPROPERTY(EditAnywhere,Config,meta=(ClampMin="0.01",EditCondition="bIndexHistoryForQueries"))
+	float HistoryIndexBucketTime{0.25f};
+	//Grid cell size of the history query index, in cm
+	UPROPERTY(EditAnywhere,Config,meta=(ClampMin="1",EditCondition="bIndexHistoryForQueries"))
+	float HistoryIndexCellSize{1000.f};
+	//Cell size of the grid that finds the actors inside a rewound volume, in cm
+	UPROPERTY(EditAnywhere,Config,meta=(ClampMin="1"))
+	float ActorGridCellSize{2000.f};
 };
@@ -0,0 +1,151 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "RewindRingBuffer.h"
+
+/**
+ * Ring of frames plus a fixed-stride pose pool that shares the ring's slots.
+ *
+ * Every frame owns PoseStride elements of the pool at its physical slot, so pose data lives in one
+ * contiguous allocation instead of an array per frame. The pool is relinearized in lockstep whenever
+ * the ring grows.
+ */
+template<typename FrameType, typename PoseElementType>
+class TRewindFrameStore
+{
+public:
+	int32 Num() const { return Frames.Num(); }
+	bool IsEmpty() const { return Frames.IsEmpty(); }
+	int32 Capacity() const { return Frames.Capacity(); }
+	int32 GetPoseStride() const { return PoseStride; }
+	//Bytes one frame takes with its pose
+	int64 GetFrameBytes() const { return sizeof(FrameType) + PoseStride * sizeof(PoseElementType); }
+
+	void Reserve(int32 InCapacity)
+	{
+		if (InCapacity <= Frames.Capacity())
+		{
+			return;
+		}
+
+		GrowPosePool(InCapacity);
+		Frames.Reserve(InCapacity);
+	}
+
+	/** Changing the stride invalidates every stored pose, so the history is dropped. */
+	void SetPoseStride(int32 InPoseStride)
+	{
+		if (InPoseStride == PoseStride)
+		{
+			return;
+		}
+
+		Frames.Reset();
+		PoseStride = InPoseStride;
+		PosePool.Reset();
+		PosePool.SetNumUninitialized(Frames.Capacity() * PoseStride);
+	}
+
+	FrameType& AddTail_GetRef()
+	{
+		if (Frames.Num() == Frames.Capacity())
+		{
+			Reserve(FMath::Max(Frames.Capacity() * 2, 16));
+		}
+		return Frames.AddTail_GetRef();
+	}
+
+	FrameType& AddHead_GetRef()
+	{
+		if (Frames.Num() == Frames.Capacity())
+		{
+			Reserve(FMath::Max(Frames.Capacity() * 2, 16));
+		}
+		return Frames.AddHead_GetRef();
+	}
+
+	/** Writes InNum frames from FirstLogicalIndex on, followed by their poses, as raw memory. */
+	void CopyRawFrames(int32 FirstLogicalIndex, int32 InNum, uint8* Out) const
+	{
+		const int32 PoseBytes{PoseStride * static_cast<int32>(sizeof(PoseElementType))};
+		uint8* OutPoses{Out + InNum * sizeof(FrameType)};
+		for (int32 Index = 0; Index < InNum; ++Index)
+		{
+			FMemory::Memcpy(Out + Index * sizeof(FrameType), &Frames[FirstLogicalIndex + Index], sizeof(FrameType));
+			if (PoseBytes > 0)
+			{
+				FMemory::Memcpy(OutPoses + Index * PoseBytes, GetPose(FirstLogicalIndex + Index).GetData(), PoseBytes);
+			}
+		}
+	}
+
+	/** Inserts InNum frames laid out as CopyRawFrames writes them before the head. */
+	void PrependRawFrames(const uint8* In, int32 InNum)
+	{
+		Reserve(Frames.Num() + InNum);
+
+		const int32 PoseBytes{PoseStride * static_cast<int32>(sizeof(PoseElementType))};
+		const uint8* InPoses{In + InNum * sizeof(FrameType)};
+		for (int32 Index = InNum - 1; Index >= 0; --Index)
+		{
+			FMemory::Memcpy(&Frames.AddHead_GetRef(), In + Index * sizeof(FrameType), sizeof(FrameType));
+			if (PoseBytes > 0)
+			{
+				FMemory::Memcpy(GetPose(0).GetData(), InPoses + Index * PoseBytes, PoseBytes);
+			}
+		}
+	}
+
+	/** Overwrites a frame and its pose with another one of the store. */
+	void CopyFrame(int32 FromLogicalIndex, int32 ToLogicalIndex)
+	{
+		Frames[ToLogicalIndex] = Frames[FromLogicalIndex];
+		if (PoseStride > 0)
+		{
+			FMemory::Memcpy(GetPose(ToLogicalIndex).GetData(), GetPose(FromLogicalIndex).GetData(), PoseStride * sizeof(PoseElementType));
+		}
+	}
+
+	void PopHead() { Frames.PopHead(); }
+	void PopTail() { Frames.PopTail(); }
+	void Reset() { Frames.Reset(); }
+
+	FrameType& Head() { return Frames.Head(); }
+	const FrameType& Head() const { return Frames.Head(); }
+	FrameType& Tail() { return Frames.Tail(); }
+	const FrameType& Tail() const { return Frames.Tail(); }
+	FrameType& operator[](int32 LogicalIndex) { return Frames[LogicalIndex]; }
+	const FrameType& operator[](int32 LogicalIndex) const { return Frames[LogicalIndex]; }
+
+	TArrayView<PoseElementType> GetPose(int32 LogicalIndex)
+	{
+		return TArrayView<PoseElementType>(PosePool.GetData() + Frames.GetPhysicalIndex(LogicalIndex) * PoseStride, PoseStride);
+	}
+
+	TConstArrayView<PoseElementType> GetPose(int32 LogicalIndex) const
+	{
+		return TConstArrayView<PoseElementType>(PosePool.GetData() + Frames.GetPhysicalIndex(LogicalIndex) * PoseStride, PoseStride);
+	}
+
+private:
+	void GrowPosePool(int32 NewCapacity)
+	{
+		if (PoseStride == 0)
+		{
+			return;
+		}
+
+		// Match the ring's relinearization: logical slot i moves to physical slot i.
+		TArray<PoseElementType> NewPool;
+		NewPool.SetNumUninitialized(NewCapacity * PoseStride);
+		for (int32 Index = 0; Index < Frames.Capacity(); ++Index)
+		{
+			FMemory::Memcpy(NewPool.GetData() + Index * PoseStride, PosePool.GetData() + Frames.GetPhysicalIndex(Index) * PoseStride, PoseStride * sizeof(PoseElementType));
+		}
+		PosePool = MoveTemp(NewPool);
+	}
+
+	TRewindRingBuffer<FrameType> Frames;
+	TArray<PoseElementType> PosePool;
+	int32 PoseStride{0};
+};
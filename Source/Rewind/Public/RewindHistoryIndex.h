@@ -0,0 +1,87 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/ObjectKey.h"
+
+class AActor;
+
+//Collision volume of an actor in its own space, captured when it is registered
+struct FRewindHistoryShape
+{
+	//Characters are a capsule along the actor's up axis, centred on its location. Everything else is a box.
+	bool bCapsule{false};
+	float CapsuleRadius{0.f};
+	//Including the hemispheres, as the capsule component has it
+	float CapsuleHalfHeight{0.f};
+	//Encloses the capsule for characters
+	FBox LocalBox{FVector::ZeroVector, FVector::ZeroVector};
+
+	FBox GetWorldBounds(const FTransform& Transform) const { return LocalBox.TransformBy(Transform); }
+};
+
+//What was last indexed for an actor, kept by the caller for each actor
+struct FRewindIndexCursor
+{
+	double Timestamp{0.0};
+	FBox Bounds{ForceInit};
+	//Bucket the cells were last added to and their range, so an actor that stays put isn't added again
+	int64 Bucket{INDEX_NONE};
+	FIntVector MinCell{FIntVector::ZeroValue};
+	FIntVector MaxCell{FIntVector::ZeroValue};
+};
+
+/**
+ * Broad phase of the history queries: where every actor went, bucketed by time slice and uniform grid cell.
+ *
+ * Each recorded frame adds the bounds the actor swept since its previous one to every bucket in between, so any
+ * interpolated transform of a bucket's time lies within what the bucket holds. Buckets form a ring covering the recorded
+ * window and are reused as the clock moves on. Entries only ever grow a bucket, dropped or merged frames leave it
+ * conservative rather than wrong. A sweep too wide for the grid, such as a teleport, goes into a per-bucket list every
+ * query of that bucket tests instead.
+ */
+class REWIND_API FRewindHistoryIndex
+{
+public:
+	using FCandidates = TArray<TObjectKey<AActor>, TInlineAllocator<64>>;
+
+	//Drops everything indexed if the layout changes
+	void Configure(float InBucketTime, float InCellSize, float InWindow);
+	bool IsConfigured() const { return !Buckets.IsEmpty(); }
+	void Reset();
+
+	//Adds the bounds the actor swept from the cursor's frame to this one and moves the cursor on
+	void AddFrame(TObjectKey<AActor> InActor, double Timestamp, const FBox& Bounds, FRewindIndexCursor& InOutCursor);
+
+	//Forgets the buckets after Timestamp, for history that playback consumed
+	void DiscardAfter(double Timestamp);
+
+	//Appends, once each, the actors whose indexed bounds at Timestamp share a cell with QueryBounds
+	void Gather(double Timestamp, const FBox& QueryBounds, FCandidates& OutCandidates) const;
+
+private:
+	struct FBucket
+	{
+		int64 Index{INDEX_NONE};
+		TMap<FIntVector, TArray<TObjectKey<AActor>>> Cells;
+		//Sweeps spanning more cells than are worth filling, with their bounds
+		TArray<TPair<TObjectKey<AActor>, FBox>> WideSweeps;
+	};
+
+	int64 GetBucketIndex(double Timestamp) const { return FMath::FloorToInt64(Timestamp / BucketTime); }
+	FIntVector GetCell(const FVector& Location) const;
+	//Null if the bucket already went out of the ring
+	FBucket* GetBucket(int64 BucketIndex);
+
+	float BucketTime{0.f};
+	float CellSize{0.f};
+	TArray<FBucket> Buckets;
+};
+
+namespace RewindHistoryQuery
+{
+	REWIND_API FRewindHistoryShape MakeShape(const AActor* InActor);
+
+	//Sphere of Radius swept from Start to End against the shape placed at Transform. OutTime is the fraction of the way
+	//to End at first contact, 0 if it starts inside. A zero radius makes it a line trace.
+	REWIND_API bool SweepSphere(const FRewindHistoryShape& Shape, const FTransform& Transform, const FVector& Start, const FVector& End, float Radius, float& OutTime);
+}
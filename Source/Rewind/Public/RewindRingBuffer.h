@@ -0,0 +1,117 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Fixed-capacity circular history.
+ *
+ * Slots are constructed once and recycled: popping only moves the head/tail cursors, so an element
+ * that owns heap memory keeps it for the next push. Capacity grows (doubling) only when a push finds
+ * the buffer full, at which point the storage is linearized so logical index == physical index.
+ */
+template<typename ElementType>
+class TRewindRingBuffer
+{
+public:
+	TRewindRingBuffer() = default;
+
+	int32 Num() const { return Count; }
+	bool IsEmpty() const { return Count == 0; }
+	int32 Capacity() const { return Storage.Num(); }
+
+	/** Grows the buffer to hold at least InCapacity elements. Never shrinks. */
+	void Reserve(int32 InCapacity)
+	{
+		if (InCapacity <= Storage.Num())
+		{
+			return;
+		}
+
+		TArray<ElementType> NewStorage;
+		NewStorage.SetNum(InCapacity);
+
+		// Move every slot, used or not, so recycled elements keep their allocations.
+		const int32 OldCapacity{Storage.Num()};
+		for (int32 Index = 0; Index < OldCapacity; ++Index)
+		{
+			NewStorage[Index] = MoveTemp(Storage[GetPhysicalIndex(Index)]);
+		}
+
+		Storage = MoveTemp(NewStorage);
+		HeadIndex = 0;
+	}
+
+	/** Appends a slot after the tail and returns it. The slot holds whatever was last stored in it. */
+	ElementType& AddTail_GetRef()
+	{
+		if (Count == Storage.Num())
+		{
+			Reserve(FMath::Max(Storage.Num() * 2, 16));
+		}
+
+		++Count;
+		return Storage[GetPhysicalIndex(Count - 1)];
+	}
+
+	/** Prepends a slot before the head and returns it. The slot holds whatever was last stored in it. */
+	ElementType& AddHead_GetRef()
+	{
+		if (Count == Storage.Num())
+		{
+			Reserve(FMath::Max(Storage.Num() * 2, 16));
+		}
+
+		HeadIndex = HeadIndex == 0 ? Storage.Num() - 1 : HeadIndex - 1;
+		++Count;
+		return Storage[HeadIndex];
+	}
+
+	void PopHead()
+	{
+		check(Count > 0);
+		HeadIndex = GetPhysicalIndex(1);
+		--Count;
+	}
+
+	void PopTail()
+	{
+		check(Count > 0);
+		--Count;
+	}
+
+	/** Drops every element but keeps the storage. */
+	void Reset()
+	{
+		HeadIndex = 0;
+		Count = 0;
+	}
+
+	ElementType& Head() { check(Count > 0); return Storage[HeadIndex]; }
+	const ElementType& Head() const { check(Count > 0); return Storage[HeadIndex]; }
+	ElementType& Tail() { check(Count > 0); return Storage[GetPhysicalIndex(Count - 1)]; }
+	const ElementType& Tail() const { check(Count > 0); return Storage[GetPhysicalIndex(Count - 1)]; }
+
+	/** Logical access, 0 is the oldest element. */
+	ElementType& operator[](int32 LogicalIndex)
+	{
+		checkSlow(LogicalIndex >= 0 && LogicalIndex < Count);
+		return Storage[GetPhysicalIndex(LogicalIndex)];
+	}
+
+	const ElementType& operator[](int32 LogicalIndex) const
+	{
+		checkSlow(LogicalIndex >= 0 && LogicalIndex < Count);
+		return Storage[GetPhysicalIndex(LogicalIndex)];
+	}
+
+	int32 GetPhysicalIndex(int32 LogicalIndex) const
+	{
+		const int32 Index{HeadIndex + LogicalIndex};
+		return Index >= Storage.Num() ? Index - Storage.Num() : Index;
+	}
+
+private:
+	TArray<ElementType> Storage;
+	int32 HeadIndex{0};
+	int32 Count{0};
+};
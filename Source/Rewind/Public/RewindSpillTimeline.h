@@ -0,0 +1,117 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/Future.h"
+#include "RewindTypes.h"
+
+class IFileHandle;
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+//Where a block of an actor's oldest frames went on disk
+struct FRewindSpilledChunk
+{
+	int32 SegmentIndex{INDEX_NONE};
+	int64 Offset{0};
+	int64 Size{0};
+	int32 NumFrames{0};
+	float RecordedTime{0.f};
+	FRewindHistoryFormat Format;
+};
+
+//A segment's file on disk. It is deleted once the timeline, the writes still queued to it and every mapping of it have
+//let it go, so neither a worker nor a mapping ever sees it vanish.
+struct FRewindSpillSegmentFile
+{
+	~FRewindSpillSegmentFile();
+
+	FString Path;
+	//Only touched by the write tasks, which run one at a time. Opened by the first and closed when the segment is sealed.
+	TUniquePtr<IFileHandle> Writer;
+	bool bOpened{false};
+};
+
+//A spilled chunk mapped back into memory
+struct FRewindMappedChunk
+{
+	~FRewindMappedChunk();
+
+	TUniquePtr<IMappedFileHandle> File;
+	TUniquePtr<IMappedFileRegion> Region;
+	//Keeps the segment's file until the mapping is gone
+	TSharedPtr<FRewindSpillSegmentFile, ESPMode::ThreadSafe> SegmentFile;
+
+	TConstArrayView<uint8> GetBytes() const;
+};
+
+//An actor's history on disk, older than everything it has in memory
+struct FRewindSpillState
+{
+	//Oldest first
+	TArray<FRewindSpilledChunk> Chunks;
+	int32 NumFrames{0};
+	float RecordedTime{0.f};
+
+	//Mapping of the newest chunk, started ahead of the rewind cursor
+	TFuture<TUniquePtr<FRewindMappedChunk>> Prefetch;
+
+	bool IsEmpty() const { return Chunks.IsEmpty(); }
+};
+
+/**
+ * Append-only on-disk tier of the recorded histories.
+ *
+ * Chunks of the actors' oldest frames are appended, as the raw bytes their frame stores hold, to segment files of
+ * bounded size. A segment is sealed once it is full or playback needs it, and only then are its chunks memory-mapped
+ * back. A segment's file is deleted as soon as none of its chunks is referenced.
+ *
+ * The game thread never touches the files: writes run as a chain of worker tasks, and mapping waits on the writes
+ * queued before it.
+ */
+class REWIND_API FRewindSpillTimeline
+{
+public:
+	~FRewindSpillTimeline();
+
+	//Starts a timeline in an empty directory of its own
+	void Open(const FString& InDirectory, int64 InSegmentBytes);
+	//Waits for the queued writes, then drops every segment and the directory
+	void Close();
+	bool IsOpen() const { return !Directory.IsEmpty(); }
+
+	//Queues the bytes at the end of the current segment and points the chunk at them. They reach the file on Flush.
+	void Append(TConstArrayView<uint8> Bytes, FRewindSpilledChunk& InOutChunk);
+	//Hands everything appended since the last flush to a worker as one write. While the previous write still runs,
+	//the bytes stay queued for the next flush instead.
+	void Flush();
+	//Queues the rest of the current segment and its closing, so its chunks can be mapped once that is done
+	void Seal();
+
+	//Maps the chunk and touches its pages on a worker thread. Seals its segment first if needed.
+	TFuture<TUniquePtr<FRewindMappedChunk>> Prefetch(const FRewindSpilledChunk& Chunk);
+	//Drops the chunk's reference to its segment, deleting the file with the last one
+	void Release(const FRewindSpilledChunk& Chunk);
+
+private:
+	struct FSegment
+	{
+		TSharedPtr<FRewindSpillSegmentFile, ESPMode::ThreadSafe> File;
+		int64 Size{0};
+		int32 NumChunks{0};
+		bool bSealed{false};
+	};
+
+	void DeleteSegment(int32 SegmentIndex);
+	//Starts a worker writing PendingWrite to the current segment once the previous write is done
+	void StartWrite(bool bCloseSegment);
+
+	FString Directory;
+	int64 SegmentBytes{0};
+
+	TMap<int32, FSegment> Segments;
+	int32 WritingSegment{INDEX_NONE};
+	int32 NextSegmentIndex{0};
+	TArray<uint8> PendingWrite;
+	//Latest write task. Each waits for the one before, so it is done once everything queued so far is on disk.
+	TSharedFuture<void> WriteTask;
+};
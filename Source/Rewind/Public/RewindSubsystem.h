@@ -3,6 +3,8 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "RewindActorRegistry.h"
+#include "RewindBranchTree.h"
 #include "RewindTypes.h"
 #include "Subsystems/WorldSubsystem.h"
 #include "RewindSubsystem.generated.h"
@@ -14,8 +16,11 @@ UCLASS()
 class REWIND_API URewindSubsystem : public UTickableWorldSubsystem
 {
 	GENERATED_BODY()
+	friend class FRewindStressScenario;
+	friend class URewindComponent;
 public:
-	UFUNCTION(BlueprintCallable,Category="TimeSync|RewindSubsystem")
+	//Registers InActor with its own rewind component, which already does so in BeginPlay
+	UFUNCTION(BlueprintCallable,Category="TimeSync|RewindSubsystem",meta=(DeprecatedFunction,DeprecationMessage="The Rewind component registers its owner in BeginPlay. Add one to the actor instead."))
 	void AddActor(AActor* InActor,URewindComponent* InComponent);
 	UFUNCTION(BlueprintCallable,Category="TimeSync|RewindSubsystem")
 	void RemoveActor(AActor* InActor);
@@ -23,20 +28,169 @@ public:
 	bool IsReversing() const;
 	UFUNCTION(BlueprintCallable,Category="TimeSync|RewindSubsystem")
 	void SetRewindConfig(const FRewindConfig& InRewindConfig );
+
+	//Interpolated state of InActor TimeAgo seconds before the latest recorded frame, without touching the history or the actor
+	UFUNCTION(BlueprintCallable,Category="TimeSync|RewindSubsystem")
+	bool SampleAt(AActor* InActor, float TimeAgo, FRewindSample& OutSample);
+	//Moves every actor to where it was TimeAgo seconds ago without consuming history. Recording pauses until EndSeek.
+	UFUNCTION(BlueprintCallable,Category="TimeSync|RewindSubsystem")
+	void SeekTo(float TimeAgo);
+
+	//Recording clock of the latest recorded frame, in seconds. History queries take their timestamps on this clock,
+	//so a server compensating a client's lag queries GetRecordingClock() minus the client's latency.
+	UFUNCTION(BlueprintCallable,Category="TimeSync|RewindSubsystem")
+	double GetRecordingClock() const;
+	//Sphere of Radius swept from Start to End against every actor as it was at Timestamp, with the exact interpolated
+	//transforms of the recorded history. Reads the histories only, never the live scene, and fails for actors whose history
+	//in memory doesn't reach back that far. Hits are sorted by distance. A zero radius makes it a line trace.
+	UFUNCTION(BlueprintCallable,Category="TimeSync|RewindSubsystem")
+	bool SweepHistory(double Timestamp, const FVector& Start, const FVector& End, float Radius, TArray<FRewindHistoryHit>& OutHits) const;
+	//SweepHistory against a single actor
+	UFUNCTION(BlueprintCallable,Category="TimeSync|RewindSubsystem")
+	bool SweepActorHistory(AActor* InActor, double Timestamp, const FVector& Start, const FVector& End, float Radius, FRewindHistoryHit& OutHit) const;
+	//Puts the actors back on the latest recorded frame and resumes recording
+	UFUNCTION(BlueprintCallable,Category="TimeSync|RewindSubsystem")
+	void EndSeek();
+	UFUNCTION(BlueprintCallable,Category="TimeSync|RewindSubsystem")
+	bool IsSeeking() const;
+
+	//While reversing, turns playback around to go forward again through the frames it went back past. Playback ends on
+	//reaching the present, StartReverse turns it back.
+	UFUNCTION(BlueprintCallable,Category="TimeSync|RewindSubsystem")
+	void StartReplay();
+	UFUNCTION(BlueprintCallable,Category="TimeSync|RewindSubsystem")
+	bool IsReplaying() const;
+
+	//Timelines kept as branches, oldest first. Recording resuming in the middle of the history forks what came after that
+	//point off into one, up to the settings' MaxTimelineBranches.
+	UFUNCTION(BlueprintCallable,Category="TimeSync|RewindSubsystem")
+	TArray<int32> GetBranchIds() const;
+	UFUNCTION(BlueprintCallable,Category="TimeSync|RewindSubsystem")
+	int32 GetCurrentBranchId() const;
+	//Rebuilds the branch's timeline from the timelines it forked from and puts the actors on its newest frame. What the
+	//current timeline recorded after the fork points becomes a branch in turn. Fails while reversing or seeking.
+	UFUNCTION(BlueprintCallable,Category="TimeSync|RewindSubsystem")
+	bool SwitchToBranch(int32 BranchId);
+
+	//Rewinds only the registered actors inside Volume, as a group named GroupName, while every other actor keeps recording.
+	//Each actor goes back from its newest frame at Config's speed or curve, and the group ends itself once its actors have
+	//fewer than Config.MinAvgThreshold frames left on average. Returns how many actors joined, 0 if none did. Fails while
+	//reversing or seeking, or if the name is taken. Actors already rewinding with another group are left to it.
+	UFUNCTION(BlueprintCallable,Category="TimeSync|RewindSubsystem")
+	int32 StartVolumeReverse(FName GroupName, const FBox& Volume, const FRewindConfig& Config);
+	//StartVolumeReverse over the given actors instead of a volume
+	UFUNCTION(BlueprintCallable,Category="TimeSync|RewindSubsystem")
+	int32 StartGroupReverse(FName GroupName, const TArray<AActor*>& InActors, const FRewindConfig& Config);
+	//Stops the group where it is and resumes recording its actors
+	UFUNCTION(BlueprintCallable,Category="TimeSync|RewindSubsystem")
+	void EndGroupReverse(FName GroupName);
+	UFUNCTION(BlueprintCallable,Category="TimeSync|RewindSubsystem")
+	bool IsGroupReversing(FName GroupName) const;
+
+	//Bytes counted against the memory budget: live histories, the frames playback went back past, timeline branches
+	//and physics bodies
+	UFUNCTION(BlueprintCallable,Category="TimeSync|RewindSubsystem")
+	int64 GetHistoryMemoryBytes() const;
+	UFUNCTION(BlueprintCallable,Category="TimeSync|RewindSubsystem")
+	int64 GetActorHistoryMemoryBytes(AActor* InActor) const;
+
+	//Writes the in-memory history of every actor, with the bone layouts it needs, to Filename. The histories are copied
+	//on the game thread and the file written on a worker; IsSavingTimeline tells when it is done.
+	UFUNCTION(BlueprintCallable,Category="TimeSync|RewindSubsystem")
+	bool SaveTimeline(const FString& Filename);
+	//Replaces the histories with the ones saved in Filename. Actors are matched by path name, registered actors missing
+	//from the file start over. Fails while reversing or seeking.
+	UFUNCTION(BlueprintCallable,Category="TimeSync|RewindSubsystem")
+	bool LoadTimeline(const FString& Filename);
+	UFUNCTION(BlueprintCallable,Category="TimeSync|RewindSubsystem")
+	bool IsSavingTimeline() const;
+
+	//Logs the Count actors with the most history in memory, with their pose and on-disk share. Rewind.DumpTopActors.
+	void DumpTopActors(int32 Count) const;
 protected:
 	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	//Registers the component's owner. The component calls it from BeginPlay, and drops it again in its EndPlay.
+	void RegisterActor(AActor* InActor,URewindComponent* InComponent);
 	
-	void HandleForwardRecording(float DeltaTime, FActorFrameSnapshot& Snapshot);
+	void HandleForwardRecording(float DeltaTime);
+
+	//Publishes the history counters of the Rewind stat group and Insights
+	void UpdateStats() const;
+
+	//Sets each actor's recording LOD from its distance to the players' view points and whether it was rendered lately
+	void UpdateSignificance();
+
+	//Cuts RecordSlots down to the always full fidelity actors plus as many others, round-robin from RecordCursor, as the
+	//measured cost per actor fits in the budget. At least one other is kept so every actor gets its turn.
+	void FitRecordingBudget(float BudgetMicroseconds);
+
+	//Trims, captures and stores one actor's frame, covering the time since its last one. Minimal LOD actors keep at most
+	//MinimalRecordedTimeSeconds. Touches nothing but the slot's own history, so slots can run in parallel.
+	void RecordSnapshot(int32 Slot, float RecordedTimeSeconds, float MinimalRecordedTimeSeconds, FRewindScratch& Scratch);
+	//Reads the actor's transform, velocities and pose. Returns whether the pose was captured into Scratch.CapturedPose.
+	bool CaptureSnapshot(int32 Slot, float DeltaTime, FRewindScratch& Scratch, FActorFrameSnapshot& OutSnapshot) const;
+	//Captures every physics body of the slot's mesh under one read lock, as a frame of the same timestamp as the
+	//snapshot. Slots can run in parallel.
+	void RecordBodies(int32 Slot, float RecordedTimeSeconds);
+
+	//Brings the histories back under the settings' memory budget: drops timeline branches, oldest first, then thins old
+	//frames, shortens the windows of low priority actors and drops the oldest frames. Shortened windows grow back while
+	//there is room.
+	void EnforceMemoryBudget(float DeltaTime);
+
+	//Adds the bounds of the frames just recorded to the history query index
+	void IndexRecordedBounds(float RecordedTimeSeconds);
+
+	//Narrow phase of the history queries against one slot
+	bool SweepSlot(int32 Slot, double Timestamp, const FVector& Start, const FVector& End, float Radius, FRewindHistoryHit& OutHit) const;
+
+	//Moves each history's oldest chunk to disk once it holds a chunk more than the recorded time, and drops spilled
+	//chunks past the spill window
+	void SpillHistories(float RecordedTimeSeconds);
+
+	//Starts mapping spilled chunks ahead of the rewind cursor and puts the mapped ones back in front of the histories
+	void RestoreSpilledHistories();
+	//RestoreSpilledHistories for one slot
+	void RestoreSpilledHistory(int32 Slot, float PrefetchTime);
+
+	//Forgets an actor's spilled frames, once they can no longer join its history
+	void DiscardSpilledFrames(int32 Slot);
+
+	void RemoveSlot(int32 Slot);
+
+	//Sizes WorkerScratch for a ParallelFor over NumJobs items and returns it
+	TArrayView<FRewindScratch> GetWorkerScratch(int32 NumJobs, int32 MinBatchSize);
 
 	void HandleReversePlayback(float DeltaTime);
 
-	void RemovePendingKillActorsOrRequested();
+	//Steps every gathered playback job and applies the results. Returns the frames the jobs have left.
+	int32 RunPlaybackJobs(float DeltaTime, float RewindSpeed, const FRewindConfig& Config);
+
+	//Steps the group's actors back and ends the group once they run out of history
+	void HandleGroupPlayback(int32 GroupIndex, float DeltaTime);
 
-	void CalculateSnapshot(FRewindedActorFrameSnapshot& SnapshotOut, bool bIsCharacter);
+	//Takes the slots out of recording and starts them back from their newest frames as a group. Returns the group size.
+	int32 StartGroup(FName GroupName, TConstArrayView<int32> Slots, const FRewindConfig& Config);
+	void EndGroup(int32 GroupIndex);
+	//Global playback, seeking and timeline swaps take every actor, so they end the groups first
+	void EndAllGroups();
+	int32 FindGroup(FName GroupName) const;
+
+	//Removes the actors whose removal was requested while the registry was being walked
+	void RemovePendingActors();
+
+	//Newest frame of any history, or the recording clock if they are all empty
+	double GetNewestTimestamp() const;
+
+	//Walks one actor's history back by DeltaTime, at Config's curve or else RewindSpeed, and interpolates its state into
+	//the job. Touches nothing but the job's own slot and pose, so jobs can run in parallel.
+	void CalculateSnapshot(FRewindPlaybackJob& Job, float DeltaTime, float RewindSpeed, const FRewindConfig& Config, FRewindScratch& Scratch);
 	
 	
 	virtual void Tick(float DeltaTime) override;
 	virtual void Deinitialize() override;
+	static void AddReferencedObjects(UObject* InThis, FReferenceCollector& Collector);
 	virtual TStatId GetStatId() const override {
 		RETURN_QUICK_DECLARE_CYCLE_STAT(URewindSubsystem, STATGROUP_Tickables);
 	}
@@ -44,9 +198,28 @@ protected:
 	
 	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override{ return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;};
 
-	static void SetSnapshotVariables(AActor* InActor, const FVector& SnapshotLocation, const FRotator& SnapshotRotation, const FVector& SnapshotLinearVelocity, const FVector& SnapshotAngularVelocity);
+	//Teleports the actor to the snapshot in a single deferred move and writes its body's velocities in one physics
+	//command. Actors already at the snapshot's transform aren't moved, but still get its velocities.
+	void ApplySnapshot(int32 Slot, const FRewindedActorFrameSnapshot& Snapshot);
+
+	//Blends the slot's recorded bodies at Time into its body states
+	bool SampleBodies(int32 Slot, double Time);
+	//Writes the body states to the mesh's simulating bodies in one batched physics write
+	void ApplyBodies(int32 Slot);
+
+	//Vectorized blend of two poses recorded against the same bone layout, without any name checks
+	static void InterpPoseTransforms(TConstArrayView<FTransform> Current, TConstArrayView<FTransform> Target, float Alpha, TArrayView<FTransform> Out);
+
+	//Blends the two frames' poses in place into the component's back pose. The caller publishes it once the tick is done.
+	void InterpTargetPose(URewindComponent& InComponent, const FActorData& Data, int32 RightIndex, int32 LeftIndex, float Fraction, FRewindScratch& Scratch) const;
+
+	int32 FindOrAddBoneLayout(const USkeletalMesh* InSkeletalMesh);
+
+	//Points the actor at its mesh's bone layout and sizes its pose pool. Must run before a frame is added.
+	void UpdatePoseLayout(FActorData& Data, const USkeletalMeshComponent* InMesh);
 
-	static FPoseSnapshot InterpPoseSnapshotTo(const FPoseSnapshot& Current, const FPoseSnapshot& Target, float DeltaTime, float InterpSpeed);
+	//Writes the mesh's local-space pose from its evaluated component-space transforms. Returns false if the mesh has no evaluated pose yet.
+	static bool CapturePose(const FRewindBoneLayout& Layout, const USkeletalMeshComponent* InMesh, TArrayView<FTransform> OutPose);
 
 	
 	
@@ -68,13 +241,73 @@ protected:
 
 	bool bShouldContinueRewinding{true};
 
+	bool bSeeking{false};
 
-	TArray<TWeakObjectPtr<AActor>> PendingRemoveActors;
+	//Set while playback goes forward through the futures rather than back through the histories
+	bool bReplaying{false};
 
-	TSet<FRewindActor> ReverseActors;
-	//TArray<FRewindActor> ReverseActors;
-	
-	TMap<TWeakObjectPtr<AActor>, FActorData> ActorsData;
+	//Set while a loop walks the registry slots. Removals are deferred until it ends, since they move slots.
+	bool bIteratingRegistry{false};
+
+	//Marks the registry as being walked and applies the deferred removals when the outermost scope ends
+	struct FRegistryIterationScope
+	{
+		explicit FRegistryIterationScope(URewindSubsystem& InSubsystem);
+		~FRegistryIterationScope();
+
+		URewindSubsystem& Subsystem;
+		bool bOutermost;
+	};
+
+	//Time since the last recorded sample when RewindConfig.SampleRate is set
+	float SampleAccumulator{0.f};
+
+	//Time since the last significance pass
+	float SignificanceAccumulator{0.f};
+
+	//Running average of the time capturing and storing one actor's frame takes, in microseconds
+	float RecordCostPerActor{2.f};
+	//Slot the next budgeted recording step starts from
+	int32 RecordCursor{0};
+
+	//Timestamp of the latest recorded frame
+	double RecordingClock{0.0};
+
+
+	TArray<TObjectKey<AActor>> PendingRemoveActors;
+
+	//Every registered actor, its cached pointers, playback cursor and history
+	FRewindActorRegistry Registry;
+
+	//Disk tier of the histories, opened the first time one spills
+	FRewindSpillTimeline SpillTimeline;
+
+	//Broad phase of the history queries, configured the first time it is enabled
+	FRewindHistoryIndex HistoryIndex;
+
+	//Timelines the live one forked from or was switched away from
+	FRewindBranchTree BranchTree;
+
+	//Groups rewinding while the rest records, in the order they started
+	TArray<FRewindGroup> Groups;
 	
 	FRewindConfig RewindConfig;
+
+	//Bone names and hierarchy registered once per skeletal mesh, shared by every recorded pose
+	TArray<FRewindBoneLayout> BoneLayouts;
+	TMap<TObjectKey<USkeletalMesh>, int32> BoneLayoutIds;
+
+	FRewindScratch GameThreadScratch;
+
+	//Reused every tick
+	TArray<FRewindPlaybackJob> PlaybackJobs;
+	TArray<FRewindScratch> WorkerScratch;
+	TArray<uint8> SpillBuffer;
+	TArray<int32> RecordSlots;
+	TArray<int32> BudgetedSlots;
+	TArray<int32> GroupSlots;
+	TArray<FVector> ViewLocations;
+	TFuture<bool> PendingTimelineSave;
+	TArray<int32> BudgetPriorities;
+	TArray<TPair<double, int32>> BudgetOldestHeads;
 };
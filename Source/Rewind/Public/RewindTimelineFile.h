@@ -0,0 +1,61 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "RewindTypes.h"
+
+enum class ERewindTimelineVersion : uint32
+{
+	Initial = 1,
+
+	Latest = Initial
+};
+
+//Where one actor's frames sit in the payload that follows the header
+struct FRewindTimelineActorEntry
+{
+	//Path name of the actor the history is loaded back into
+	FString ActorPath;
+	FRewindHistoryFormat Format;
+	//The actor's current bone layout, an index into the header's layouts
+	int32 PoseLayoutId{INDEX_NONE};
+	int32 NumFrames{0};
+	//Relative to the start of the payload
+	int64 Offset{0};
+	int64 Size{0};
+};
+
+/**
+ * Everything of a saved timeline but the frames themselves.
+ *
+ * The frames follow as one payload holding each history's raw frame store bytes, so they are written and read back
+ * with plain copies. That ties a file to the frame layout of the build that wrote it, which the header records.
+ */
+struct FRewindTimelineHeader
+{
+	uint32 Magic{0};
+	uint32 Version{0};
+	uint32 FrameSize{0};
+	uint32 PackedFrameSize{0};
+	uint32 TransformSize{0};
+
+	double RecordingClock{0.0};
+	TArray<FRewindBoneLayout> Layouts;
+	TArray<FRewindTimelineActorEntry> Actors;
+};
+
+namespace RewindTimelineFile
+{
+	static constexpr uint32 Magic{0x4C545752}; // "RWTL"
+
+	//Header describing this build's frame layout, with nothing recorded yet
+	REWIND_API FRewindTimelineHeader MakeHeader();
+
+	REWIND_API void SerializeHeader(FArchive& Ar, FRewindTimelineHeader& Header);
+
+	//True if the header was written by a known version with the same frame layout as this build
+	REWIND_API bool IsCompatible(const FRewindTimelineHeader& Header);
+
+	//True if every entry has a known format, a pose layout from the header's table and exactly its frames' bytes
+	//within the PayloadSize bytes that follow the header
+	REWIND_API bool IsValid(const FRewindTimelineHeader& Header, int64 PayloadSize);
+}
@@ -2,10 +2,13 @@
 
 #include "CoreMinimal.h"
 #include "RewindComponent.h"
-#include "Containers/List.h"
+#include "RewindCompression.h"
+#include "RewindFrameStore.h"
+#include "UObject/ObjectKey.h"
 #include "RewindTypes.generated.h"
 
-
+class USkeletalMesh;
+class ACharacter;
 
 
 struct FActorFrameSnapshot 
@@ -32,9 +35,25 @@ struct FActorFrameSnapshot
 	FVector AngularVelocity{FVector::ZeroVector};
 	
 	float DeltaTime = 0.f;
+	//Recording clock at capture, in seconds. Increases along the history.
+	double Timestamp = 0.0;
 
-	//todo: find a good place to put this so that every actor doesnt have this data
-	FPoseSnapshot PoseSnapshot;
+	//Whether the velocities describe the motion between frames and can drive Hermite interpolation
+	bool bHasLinearVelocity{false};
+	bool bHasAngularVelocity{false};
+
+	//Index into the subsystem's bone layout table. The bone transforms live in the frame store's pose pool.
+	int32 PoseLayoutId{INDEX_NONE};
+};
+
+//Bone layout shared by every frame recorded from the same skeletal mesh
+struct FRewindBoneLayout
+{
+	FName SkeletalMeshName;
+	TArray<FName> BoneNames;
+	TArray<int32> ParentIndices;
+
+	int32 Num() const { return BoneNames.Num(); }
 };
 
 struct FRewindedActorFrameSnapshot
@@ -45,23 +64,33 @@ struct FRewindedActorFrameSnapshot
 		const FVector& InLocation,
 		const FRotator& InRotation,
 		const FVector& InLinearVelocity,
-		const FVector& InAngularVelocity,
-		const FPoseSnapshot& InPoseSnapshot
+		const FVector& InAngularVelocity
 	)
 		: Location(InLocation)
 		, Rotation(InRotation)
 		, LinearVelocity(InLinearVelocity)
 		, AngularVelocity(InAngularVelocity)
-		, PoseSnapshot(InPoseSnapshot)
 	{}	
 
 	FVector Location{FVector::ZeroVector};
 	FRotator Rotation{FRotator::ZeroRotator};
 	FVector LinearVelocity{FVector::ZeroVector};
 	FVector AngularVelocity{FVector::ZeroVector};
-	FPoseSnapshot PoseSnapshot;
 };
 
+//Buffers for decoding frames and capturing poses. One per thread that records or reads histories.
+struct FRewindScratch
+{
+	FActorFrameSnapshot Frames[3];
+	TArray<FTransform> Poses[3];
+	TArray<FTransform> CapturedPose;
+};
+
+//Blend used by playback. Right is the later frame, Left the earlier one, Fraction goes from Right (0) to Left (1).
+//Location and rotation follow a cubic Hermite curve built from the recorded velocities when both frames have them,
+//otherwise a lerp and a quaternion slerp. The interval between the frames is Right.DeltaTime.
+REWIND_API FRewindedActorFrameSnapshot InterpolateFrames(const FActorFrameSnapshot& Right, const FActorFrameSnapshot& Left, float Fraction);
+
 /*struct FPoseableActorFrameSnapshot : public FActorFrameSnapshot
 {
 	FPoseableActorFrameSnapshot() = default;
@@ -82,31 +111,218 @@ struct FRewindedActorFrameSnapshot
 	FPoseSnapshot PoseSnapshot;
 };*/
 
-struct FActorData {
-	FActorData() = default;
+//Where playback stands in a history, in seconds back from the frame that was newest when it started
+struct FRewindPlaybackCursor
+{
+	float RunningTime{0.f};
+	//Age of the frame before the tail
+	float LeftRunningTime{0.f};
+	//Age of the tail
+	float RightRunningTime{0.f};
+};
+
+//Everything raw frames copied out of a history depend on to be read back into one
+struct FRewindHistoryFormat
+{
+	ERewindFrameCompression Compression{ERewindFrameCompression::None};
+	float MaxQuantizationError{0.f};
+	FVector QuantizationOrigin{FVector::ZeroVector};
+	bool bPackedPoseHasScale{false};
+	int32 PoseBoneCount{0};
 
-	FActorData(const FActorData& Other)
-		: bReversingTime(Other.bReversingTime),
-		  bOutOfData(Other.bOutOfData),
-		  RunningTime(Other.RunningTime),
-		  ReverseRunningTime(Other.ReverseRunningTime),
-		  RecordedTime(Other.RecordedTime) 
+	//Bytes one frame and its pose take in this format
+	int64 GetFrameBytes() const;
+
+	bool operator==(const FRewindHistoryFormat& Other) const
 	{
-		
+		return Compression == Other.Compression && MaxQuantizationError == Other.MaxQuantizationError && QuantizationOrigin == Other.QuantizationOrigin
+			&& bPackedPoseHasScale == Other.bPackedPoseHasScale && PoseBoneCount == Other.PoseBoneCount;
 	}
+	bool operator!=(const FRewindHistoryFormat& Other) const { return !(*this == Other); }
+};
+
+struct FActorData {
+	FActorData() = default;
 
-	float LeftRunningTime{};
-	float RightRunningTime{};
-	bool bReversingTime{ false };
-	bool bOutOfData;
-	float RunningTime;
-	float ReverseRunningTime;
-	float RecordedTime;
-	TDoubleLinkedList<FActorFrameSnapshot> StoredFrames;
+	//Cached so the layout table is only searched when the skeletal mesh changes
+	TObjectKey<USkeletalMesh> PoseMesh;
+	int32 PoseLayoutId{INDEX_NONE};
+
+	//Switching format drops the recorded history
+	void SetCompression(ERewindFrameCompression InCompression, float InMaxError);
+	bool IsCompressed() const { return Compression == ERewindFrameCompression::Quantized; }
+
+	//Changing the bone count drops the recorded history
+	void SetPoseBoneCount(int32 InNumBones);
+	int32 GetPoseBoneCount() const { return PoseBoneCount; }
+
+	int32 NumFrames() const { return IsCompressed() ? PackedFrames.Num() : StoredFrames.Num(); }
+	bool HasFrames() const { return NumFrames() > 0; }
+	//Sum of the stored frames' delta times, kept up to date as frames are added and popped
+	float GetRecordedTime() const { return RecordedTime; }
+	float GetFrameDeltaTime(int32 Index) const { return IsCompressed() ? PackedFrames[Index].DeltaTime : StoredFrames[Index].DeltaTime; }
+	double GetFrameTimestamp(int32 Index) const { return IsCompressed() ? PackedFrames[Index].Timestamp : StoredFrames[Index].Timestamp; }
+	int32 GetFramePoseLayoutId(int32 Index) const { return IsCompressed() ? PackedFrames[Index].PoseLayoutId : StoredFrames[Index].PoseLayoutId; }
+
+	void ReserveFrames(int32 InCapacity);
+	void PopHeadFrame();
+	void PopTailFrame();
+	void ResetFrames();
+	//Pops the oldest frames until the history covers at most MaxRecordedTime
+	void TrimHead(float MaxRecordedTime);
+
+	//Bytes taken by the stored frames and their poses
+	int64 GetMemoryBytes() const { return IsCompressed() ? PackedFrames.Num() * PackedFrames.GetFrameBytes() : StoredFrames.Num() * StoredFrames.GetFrameBytes(); }
+	//Share of GetMemoryBytes taken by the poses
+	int64 GetPoseMemoryBytes() const { return IsCompressed() ? PackedFrames.Num() * static_cast<int64>(PackedFrames.GetPoseStride()) : StoredFrames.Num() * static_cast<int64>(StoredFrames.GetPoseStride()) * sizeof(FTransform); }
+
+	FRewindHistoryFormat GetFormat() const;
+	//Bytes one frame and its pose take in the current format
+	int64 GetFrameBytes() const { return IsCompressed() ? PackedFrames.GetFrameBytes() : StoredFrames.GetFrameBytes(); }
+
+	//Appends the oldest frames, then their poses, to OutBytes as the raw memory the history holds
+	void WriteHeadFrames(int32 InNumFrames, TArray<uint8>& OutBytes) const;
+	//Same as WriteHeadFrames into memory sized for it, GetFrameBytes() per frame
+	void CopyHeadFrames(int32 InNumFrames, uint8* Out) const;
+	//Puts frames written by WriteHeadFrames back before the oldest one. Fails, leaving the history untouched, if the
+	//format they were written in is not the current one or the byte count does not match.
+	bool PrependFrames(const FRewindHistoryFormat& InFormat, TConstArrayView<uint8> Bytes, int32 InNumFrames);
+	//Replaces the history with frames written by WriteHeadFrames in any format
+	bool RestoreFrames(const FRewindHistoryFormat& InFormat, TConstArrayView<uint8> Bytes, int32 InNumFrames);
+	//Points every frame's pose at LayoutIdMap[PoseLayoutId], for frames recorded against another layout table
+	void RemapPoseLayoutIds(TConstArrayView<int32> LayoutIdMap);
+
+	//Folds every other frame recorded before BeforeTimestamp into the frame after it, as long as the merged frame spans
+	//at most MaxInterval. The recorded time is unchanged. Returns the number of frames removed.
+	int32 ThinFrames(double BeforeTimestamp, float MaxInterval);
+
+	//Appends a frame. Pose is either empty or GetPoseBoneCount() local transforms.
+	void AddFrame(const FActorFrameSnapshot& Frame, TConstArrayView<FTransform> Pose);
+
+	//Like AddFrame, but first drops the current tail if interpolating between the frame before it and the new one
+	//reproduces it within tolerance. The new frame then covers the tail's span as well.
+	void AddKeyframe(const FActorFrameSnapshot& Frame, TConstArrayView<FTransform> Pose, const FRewindKeyframeReduction& Reduction, FRewindScratch& Scratch);
+
+	//One recording step: pops the oldest frames until less than MaxRecordedTime is stored, then adds the keyframe
+	void RecordFrame(const FActorFrameSnapshot& Frame, TConstArrayView<FTransform> Pose, float MaxRecordedTime, const FRewindKeyframeReduction& Reduction, FRewindScratch& Scratch);
+
+	//One playback step: moves the cursor Step seconds back, taking the frames it passes off the tail. They go to the front
+	//of Future when given, where StepReplay finds them again, and are dropped otherwise. Returns true with the pair to
+	//interpolate if the cursor lies between the last two frames. Those two are never taken: past them the cursor holds on
+	//the oldest frame. bOutExhausted is set once no more than those two are left.
+	bool StepPlayback(FRewindPlaybackCursor& Cursor, float Step, int32& OutLeftIndex, int32& OutRightIndex, float& OutFraction, bool& bOutExhausted, FActorData* Future = nullptr);
+
+	//StepPlayback the other way: moves the cursor Step seconds forward, bringing the frames it reaches back from Future onto
+	//the tail. bOutExhausted is set once Future is empty and the cursor is on the tail.
+	bool StepReplay(FRewindPlaybackCursor& Cursor, float Step, FActorData& Future, int32& OutLeftIndex, int32& OutRightIndex, float& OutFraction, bool& bOutExhausted);
+
+	//Moves the newest frame to the front of Other, which takes this history's format first if it is in another one
+	void MoveTailFrameTo(FActorData& Other);
+	//Moves Other's oldest frame onto the tail. Fails if the formats differ and this history isn't empty.
+	bool MoveHeadFrameFrom(FActorData& Other);
+
+	//Binary searches the frames around Time. Right is the later frame and Fraction goes from Right (0) to Left (1), as in playback.
+	//Times outside the history clamp to its ends. Returns false with fewer than two frames.
+	bool FindBracket(double Time, int32& OutLeftIndex, int32& OutRightIndex, float& OutFraction) const;
+
+	//Uncompressed frames are returned in place, compressed ones are decoded into Scratch
+	const FActorFrameSnapshot& GetFrame(int32 Index, FActorFrameSnapshot& Scratch) const;
+	TConstArrayView<FTransform> GetPose(int32 Index, TArray<FTransform>& Scratch) const;
+
+private:
+	//Empties the history and switches it to the format
+	void ResetToFormat(const FRewindHistoryFormat& InFormat);
+	//Gives every packed pose recorded so far a unit scale channel, for a pose that brings the first scale
+	void WidenPackedPoses();
+
+	bool CanDropTail(const FActorFrameSnapshot& Next, TConstArrayView<FTransform> NextPose, const FRewindKeyframeReduction& Reduction, FRewindScratch& Scratch) const;
+
+	ERewindFrameCompression Compression{ERewindFrameCompression::None};
+	float MaxQuantizationError{0.01f};
+	//Origin the quantized locations are relative to, picked when the window starts
+	FVector QuantizationOrigin{FVector::ZeroVector};
+	bool bPackedPoseHasScale{false};
+	int32 PoseBoneCount{0};
+	float RecordedTime{0.f};
+
+	TRewindFrameStore<FActorFrameSnapshot, FTransform> StoredFrames;
+	TRewindFrameStore<FPackedActorFrameSnapshot, uint8> PackedFrames;
 };
 
 
 
+//Interpolated state of an actor at some point of its history
+USTRUCT(BlueprintType)
+struct FRewindSample
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly)
+	FVector Location{FVector::ZeroVector};
+	UPROPERTY(BlueprintReadOnly)
+	FRotator Rotation{FRotator::ZeroRotator};
+	UPROPERTY(BlueprintReadOnly)
+	FVector LinearVelocity{FVector::ZeroVector};
+	UPROPERTY(BlueprintReadOnly)
+	FVector AngularVelocity{FVector::ZeroVector};
+};
+
+//An actor met by a history query, as it was at the queried time
+USTRUCT(BlueprintType)
+struct FRewindHistoryHit
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly)
+	TObjectPtr<AActor> Actor;
+	//Centre of the swept sphere at first contact
+	UPROPERTY(BlueprintReadOnly)
+	FVector ImpactPoint{FVector::ZeroVector};
+	//From the start of the trace to ImpactPoint
+	UPROPERTY(BlueprintReadOnly)
+	float Distance{0.f};
+	UPROPERTY(BlueprintReadOnly)
+	FVector ActorLocation{FVector::ZeroVector};
+	UPROPERTY(BlueprintReadOnly)
+	FRotator ActorRotation{FRotator::ZeroRotator};
+};
+
+//Per-actor work item of reverse playback. Filled on the game thread, evaluated on any thread, applied on the game thread.
+struct FRewindPlaybackJob
+{
+	//Registry slot of the actor
+	int32 Slot{INDEX_NONE};
+
+	//Frames left before this tick consumed any, for the end condition
+	int32 FramesRemaining{0};
+	bool bHasResult{false};
+	//Whether the slot's body states were blended for this step
+	bool bHasBodies{false};
+	FRewindedActorFrameSnapshot Result;
+};
+
+//Frames a timeline recorded after the point it forked at. The frames up to that point are its parent's and are never
+//copied, so a branch only ever holds what differs.
+struct FRewindBranch
+{
+	int32 Id{INDEX_NONE};
+	//Timeline the frames up to the fork point are taken from, the live one or another branch
+	int32 ParentId{INDEX_NONE};
+	//Frames of every actor in the branch are newer than this
+	double ForkTimestamp{0.0};
+	TMap<TObjectKey<AActor>, FActorData> Suffixes;
+
+	int64 GetMemoryBytes() const
+	{
+		int64 Bytes{0};
+		for (const auto& Suffix : Suffixes)
+		{
+			Bytes += Suffix.Value.GetMemoryBytes();
+		}
+		return Bytes;
+	}
+};
+
 USTRUCT(BlueprintType)
 struct FRewindConfig
 {
@@ -119,13 +335,20 @@ struct FRewindConfig
 	FRewindConfig(float InRewindSpeed, float InRecordedTime): RecordedTime(InRecordedTime), RewindSpeed(InRewindSpeed){}
 
 	//Calculate Interp Variables outside the GameThread. Worth only if you are going to use rewind with a lot of actors. Profile to discover.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	bool bUseMultiThreading{false};
+	//Capture and store snapshots outside the GameThread. Actors are still gathered on the GameThread.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	bool bUseParallelRecording{false};
 	//Recorded Time in Seconds
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	float RecordedTime{15.f};
 	//Default Speed. If the Curve is set, this will be ignored
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	float RewindSpeed{1.f};
+	//Recording rate in Hz, independent of the tick rate. 0 records every tick.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta=(ClampMin="0"))
+	float SampleRate{0.f};
 	//If the average frames remaining of all actors pass the MinAvgThreshold, the rewind will end 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	float MinAvgThreshold = 3.f;
@@ -144,28 +367,11 @@ struct FRewindConfig
 	
 };
 
-
-struct FRewindActor
+//Actors rewinding on their own while the rest of the world keeps recording
+struct FRewindGroup
 {
-	FRewindActor() = delete;
-
-	FRewindActor(AActor* InActor, URewindComponent* InRewindComponent)
-		: InActor(InActor), InRewindComponent(InRewindComponent) {}
-
-	TWeakObjectPtr<AActor> InActor;
-	TWeakObjectPtr<URewindComponent> InRewindComponent;
-
-	bool IsValid() const { return InActor.IsValid() && InRewindComponent.IsValid(); }
-
-	FORCEINLINE bool operator==(const FRewindActor& Other) const
-	{
-		return InActor == Other.InActor && InRewindComponent == Other.InRewindComponent;
-	}
+	FName Name;
+	TArray<TObjectKey<AActor>> Actors;
+	//Speed, curve and end condition of the group's playback
+	FRewindConfig Config;
 };
-
-// Add a custom `TSet` comparison function:
-FORCEINLINE uint32 GetTypeHash(const FRewindActor& Actor)
-{
-	return GetTypeHash(Actor.InActor);
-}
-
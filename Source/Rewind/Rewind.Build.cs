@@ -18,6 +18,7 @@ public class Rewind : ModuleRules
             {
                 "CoreUObject",
                 "Engine",
+                "PhysicsCore",
                 "Slate",
                 "SlateCore"
             }
@@ -0,0 +1,20 @@
+﻿#include "AnimGraphNode_RewindPose.h"
+
+#define LOCTEXT_NAMESPACE "AnimGraphNode_RewindPose"
+
+FText UAnimGraphNode_RewindPose::GetNodeTitle(ENodeTitleType::Type TitleType) const
+{
+	return LOCTEXT("NodeTitle", "Rewind Pose");
+}
+
+FText UAnimGraphNode_RewindPose::GetTooltipText() const
+{
+	return LOCTEXT("NodeTooltip", "Outputs the pose recorded by the owner's Rewind component while it reverses time, and Source otherwise.");
+}
+
+FString UAnimGraphNode_RewindPose::GetNodeCategory() const
+{
+	return TEXT("TimeSync");
+}
+
+#undef LOCTEXT_NAMESPACE
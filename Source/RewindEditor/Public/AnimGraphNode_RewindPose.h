@@ -0,0 +1,20 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "AnimGraphNode_Base.h"
+#include "AnimNode_RewindPose.h"
+#include "AnimGraphNode_RewindPose.generated.h"
+
+UCLASS()
+class REWINDEDITOR_API UAnimGraphNode_RewindPose : public UAnimGraphNode_Base
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, Category=Settings)
+	FAnimNode_RewindPose Node;
+
+public:
+	virtual FText GetNodeTitle(ENodeTitleType::Type TitleType) const override;
+	virtual FText GetTooltipText() const override;
+	virtual FString GetNodeCategory() const override;
+};
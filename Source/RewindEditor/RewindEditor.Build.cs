@@ -0,0 +1,27 @@
+﻿using UnrealBuildTool;
+
+public class RewindEditor : ModuleRules
+{
+    public RewindEditor(ReadOnlyTargetRules Target) : base(Target)
+    {
+        PCHUsage = ModuleRules.PCHUsageMode.UseExplicitOrSharedPCHs;
+
+        PublicDependencyModuleNames.AddRange(
+            new string[]
+            {
+                "Core",
+                "AnimGraph",
+                "Rewind"
+            }
+        );
+
+        PrivateDependencyModuleNames.AddRange(
+            new string[]
+            {
+                "CoreUObject",
+                "Engine",
+                "BlueprintGraph"
+            }
+        );
+    }
+}